@@ -0,0 +1,110 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+// Throughput of the plot to pixel transform kernels at every instruction set
+// level the CPU supports, and their largest deviation from the scalar kernel.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "transform_kernels.hpp"
+
+static const char* level_name(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::SSE2:
+    return "SSE2";
+  case SimdLevel::AVX2:
+    return "AVX2";
+  case SimdLevel::AVX512:
+    return "AVX-512";
+  default:
+    return "scalar";
+  }
+}
+
+static void run(const char* name, const AxisTransform& axis,
+                const std::vector<double>& values) {
+  const int count = static_cast<int>(values.size());
+  std::vector<float> expected(count);
+  std::vector<float> out(count);
+  transform_axis_scalar(axis, values.data(), count, expected.data());
+  for (int level = 0; level <= static_cast<int>(supported_simd_level());
+       ++level) {
+    set_simd_level(static_cast<SimdLevel>(level));
+    double best = 1e30;
+    for (int rep = 0; rep < 20; ++rep) {
+      const auto start = std::chrono::steady_clock::now();
+      transform_axis(axis, values.data(), count, out.data());
+      const std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      best = std::min(best, elapsed.count());
+    }
+    float deviation = 0.0f;
+    for (int i = 0; i < count; ++i) {
+      deviation = std::max(deviation, std::fabs(out[i] - expected[i]));
+    }
+    std::printf("%-7s %-8s %8.1f Mvalues/s  max deviation %g px\n", name,
+                level_name(static_cast<SimdLevel>(level)),
+                count / best * 1e-6, deviation);
+  }
+}
+
+int main() {
+  const int count = 1 << 22;
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> linear(-1e3, 1e3);
+  std::uniform_real_distribution<double> exponent(-3.0, 6.0);
+  std::vector<double> linear_values(count);
+  std::vector<double> log_values(count);
+  for (int i = 0; i < count; ++i) {
+    linear_values[i] = linear(rng);
+    log_values[i] = std::pow(10.0, exponent(rng));
+  }
+  // A 1920 pixel wide axis
+  const AxisTransform lin{10.0, 1920.0 / 2e3, -1e3, 1e3, 1.0, false};
+  const AxisTransform log{10.0, 1920.0 / (1e6 - 1e-3), 1e-3, 1e6, 9.0, true};
+  run("linear", lin, linear_values);
+  run("log", log, log_values);
+}
@@ -0,0 +1,118 @@
+# Copyright 2020 Joel Linn
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# 1. Redistributions of source code must retain the above copyright notice, this
+# list of conditions and the following disclaimer.
+#
+# 2. Redistributions in binary form must reproduce the above copyright notice,
+# this list of conditions and the following disclaimer in the documentation
+# and/or other materials provided with the distribution.
+#
+# 3. Neither the name of the copyright holder nor the names of its contributors
+# may be used to endorse or promote products derived from this software
+# without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+# ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+# WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+# DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+# FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+# DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+# SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+# CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+# OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#
+# You are under no obligation whatsoever to provide any bug fixes, patches, or
+# upgrades to the features, functionality or performance of the source code
+# ("Enhancements") to anyone; however, if you choose to make your Enhancements
+# available either publicly, or directly to the author of this software, without
+# imposing a separate written license agreement for such Enhancements, then you
+# hereby grant the following license: a non-exclusive, royalty-free perpetual
+# license to install, use, modify, prepare derivative works, incorporate into
+# other computer software, distribute, and sublicense such enhancements or
+# derivative works thereof, in binary and source code form.
+
+# Measures plot_line throughput in points per second for every supported
+# dtype. Each dtype is plotted twice: once with xs and ys of the same dtype,
+# which is handed directly to ImPlot's typed API, and once with xs of a
+# different dtype, which goes through the generic per-point getter.
+
+import time
+
+import mahi_gui
+from mahi_gui import imgui
+from mahi_gui import implot
+import numpy as np
+
+# float16, bool and non-native byte order (">f8" on little endian machines)
+# are not supported by ImPlot's typed API and always use the getter.
+DTYPES = ["float16", "float32", "float64", ">f8", "int8", "uint8", "int16",
+          "uint16", "int32", "uint32", "int64", "uint64"]
+
+
+def ramp(points, dtype):
+    """Ascending values from 0 to points - 1, or to the largest value the
+    dtype holds (e.g. 127 for int8) so that small types do not wrap."""
+    kind = np.dtype(dtype).kind
+    info = np.iinfo(dtype) if kind in "iu" else np.finfo(dtype)
+    return np.linspace(0, min(points - 1, info.max), points).astype(dtype)
+
+
+class Benchmark():
+    def __init__(self, dtype, points):
+        self.dtype = dtype
+        self.ys = (np.random.rand(points) * 100).astype(dtype)
+        self.xs_typed = ramp(points, dtype)
+        # Any other dtype forces the getter path
+        other = "float64" if dtype != "float64" else "float32"
+        self.xs_getter = np.arange(points).astype(other)
+        self.typed = 0.0
+        self.getter = 0.0
+
+
+class DtypeBenchmark(mahi_gui.Application):
+    POINTS = 100000
+    # Exponential moving average of the measured rates
+    SMOOTHING = 0.05
+
+    def __init__(self):
+        super().__init__(800, 600, "Python dtype Benchmark")
+        imgui.get_io().ini_filename = None
+        self.set_vsync(False)
+        imgui.disable_viewports()
+        self.benchmarks = [Benchmark(d, self.POINTS) for d in DTYPES]
+
+    def _measure(self, label, xs, ys):
+        t = time.perf_counter()
+        implot.plot_line(label, xs, ys)
+        return xs.shape[0] / max(time.perf_counter() - t, 1e-9)
+
+    def _smooth(self, old, new):
+        return new if old == 0.0 else old + self.SMOOTHING * (new - old)
+
+    def _update(self):
+        width, height = self.get_window_size()
+        imgui.begin(
+            "Python dtype Benchmark",
+            imgui.Bool(True),
+            imgui.WindowFlags.NoTitleBar | imgui.WindowFlags.NoResize | imgui.WindowFlags.NoMove)
+        imgui.set_window_pos(imgui.Vec2(0, 0))
+        imgui.set_window_size(imgui.Vec2(width, height))
+        imgui.text("{} pts per line @ {:.3f} FPS".format(self.POINTS, imgui.get_io().framerate))
+        for b in self.benchmarks:
+            imgui.text("{:>8}: typed {:8.1f} Mpts/s, getter {:8.1f} Mpts/s, speedup {:.2f}x".format(
+                b.dtype, b.typed / 1e6, b.getter / 1e6, b.typed / max(b.getter, 1.0)))
+        implot.set_next_plot_limits_x(0, self.POINTS)
+        if (implot.begin_plot("##Plot", None, None, imgui.Vec2(-1, -1), implot.Flags.NoChild)):
+            for b in self.benchmarks:
+                b.typed = self._smooth(b.typed, self._measure(b.dtype + " typed", b.xs_typed, b.ys))
+                b.getter = self._smooth(b.getter, self._measure(b.dtype + " getter", b.xs_getter, b.ys))
+            implot.end_plot()
+        imgui.end()
+
+if __name__ == "__main__":
+    app = DtypeBenchmark()
+    app.run()
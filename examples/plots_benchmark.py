@@ -35,18 +35,25 @@ class PlotBench(mahi_gui.Application):
         self.items = []
         self.render = imgui.Bool(True)
         self.animate  = imgui.Bool(False)
+        self.batched = imgui.Bool(False)
         super(PlotBench, self).__init__(500, 500, "Python Plots Benchmark")
 
         imgui.get_io().ini_filename = None
         self.set_vsync(False)
         imgui.disable_viewports()
+        # all items share the x values and store their y values as rows of
+        # one 2D array, so they can also be plotted with a single call
+        self.data_x = np.empty(self.POINTS, dtype="uint16")
+        self.data_y = np.empty((self.PLOTS, self.POINTS))
         for i in range(self.PLOTS):
             item = PlotItem()
-            item.data_x = np.empty(self.POINTS, dtype="uint16")
-            item.data_y = np.empty(self.POINTS)
+            item.data_x = self.data_x
+            item.data_y = self.data_y[i]
             item.color = self.random_color()
             item.label = "item_{}".format(i)
             self.items.append(item)
+        self.labels = [item.label for item in self.items]
+        self.colors = [item.color for item in self.items]
         self.generate_items_data()
 
     def random_color(self):
@@ -80,10 +87,15 @@ class PlotBench(mahi_gui.Application):
         imgui.checkbox("Render", self.render)
         imgui.same_line()
         imgui.checkbox("Animate", self.animate)
+        imgui.same_line()
+        imgui.checkbox("Batched", self.batched)
         imgui.text("{} lines, {} pts ea. @ {:.3f} FPS".format(self.PLOTS, self.POINTS, imgui.get_io().framerate))
         implot.set_next_plot_limits_x(0, self.POINTS)
         if (implot.begin_plot("##Plot", None, None, imgui.Vec2(-1, -1), implot.Flags.NoChild)):
-            if (self.render.value):
+            if (self.render.value and self.batched.value):
+                implot.plot_lines_2d(self.labels, self.data_x, self.data_y,
+                                     self.colors)
+            elif (self.render.value):
                 for item in self.items:
                     implot.push_style_color(implot.Color.Line, item.color)
                     implot.plot_line(item.label, item.data_x, item.data_y)
@@ -0,0 +1,197 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _FILE_MAPPING_HPP
+#define _FILE_MAPPING_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// How the pages of a mapping will be read, passed on to the OS as a hint.
+enum class AccessPattern { Normal, Sequential, Random };
+
+// Read-only memory mapping of a whole file. Pages are read from disk when
+// first touched and may be evicted again, so files larger than RAM can be
+// mapped.
+class FileMapping {
+public:
+  FileMapping(const std::string& path, AccessPattern access) {
+#ifdef _WIN32
+    // Windows takes the access pattern when opening the file only
+    const DWORD flags = access == AccessPattern::Sequential
+                            ? FILE_FLAG_SEQUENTIAL_SCAN
+                            : access == AccessPattern::Random
+                                  ? FILE_FLAG_RANDOM_ACCESS
+                                  : FILE_ATTRIBUTE_NORMAL;
+    const HANDLE file =
+        CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                    OPEN_EXISTING, flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      throw std::runtime_error("Cannot open " + path + "!");
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+      CloseHandle(file);
+      throw std::runtime_error("Cannot read the size of " + path + "!");
+    }
+    this->length = static_cast<size_t>(size.QuadPart);
+    if (this->length > 0) {
+      const HANDLE mapping =
+          CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping != nullptr) {
+        this->address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        // The view keeps the mapping alive
+        CloseHandle(mapping);
+      }
+    }
+    CloseHandle(file);
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot open " + path + ": " +
+                               std::strerror(errno));
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw std::runtime_error("Cannot read the size of " + path + "!");
+    }
+    this->length = static_cast<size_t>(st.st_size);
+    if (this->length > 0) {
+      void* address =
+          mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+      this->address = address != MAP_FAILED ? address : nullptr;
+    }
+    // The mapping keeps the file open
+    close(fd);
+    if (this->address != nullptr) {
+      advise(access, 0, this->length);
+    }
+#endif
+    if (this->length > 0 && this->address == nullptr) {
+      throw std::runtime_error("Cannot map " + path + "!");
+    }
+  }
+  ~FileMapping() {
+    if (this->address == nullptr) {
+      return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(this->address);
+#else
+    munmap(this->address, this->length);
+#endif
+  }
+  FileMapping(const FileMapping&) = delete;
+  FileMapping& operator=(const FileMapping&) = delete;
+
+  // Sets the access pattern of the bytes [offset, offset + length). Ignored
+  // on Windows, see the constructor.
+  void advise(AccessPattern access, size_t offset, size_t length) const {
+#ifndef _WIN32
+    const int advice = access == AccessPattern::Sequential ? MADV_SEQUENTIAL
+                       : access == AccessPattern::Random   ? MADV_RANDOM
+                                                           : MADV_NORMAL;
+    advise_range(advice, offset, length);
+#else
+    (void)access;
+    (void)offset;
+    (void)length;
+#endif
+  }
+
+  // Starts reading the bytes [offset, offset + length) in the background.
+  void prefetch(size_t offset, size_t length) const {
+#ifndef _WIN32
+    advise_range(MADV_WILLNEED, offset, length);
+#elif _WIN32_WINNT >= 0x0602
+    if (this->address != nullptr && offset < this->length) {
+      WIN32_MEMORY_RANGE_ENTRY range{
+          static_cast<char*>(this->address) + offset,
+          std::min(length, this->length - offset)};
+      PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#else
+    (void)offset;
+    (void)length;
+#endif
+  }
+
+  [[nodiscard]] const char* data() const {
+    return static_cast<const char*>(this->address);
+  }
+  [[nodiscard]] size_t size() const { return this->length; }
+
+private:
+#ifndef _WIN32
+  void advise_range(int advice, size_t offset, size_t length) const {
+    if (this->address == nullptr || offset >= this->length) {
+      return;
+    }
+    // madvise() takes page aligned addresses
+    static const auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t begin = offset / page * page;
+    const size_t end = std::min(offset + length, this->length);
+    madvise(static_cast<char*>(this->address) + begin, end - begin, advice);
+  }
+#endif
+
+  void* address = nullptr;
+  size_t length = 0;
+};
+
+#endif
@@ -40,113 +40,559 @@ derivative works thereof, in binary and source code form.
 ******************************************************************************/
 
 #include <implot.h>
+#include <implot_internal.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <string>
+#include <unordered_map>
 
 #include "imgui_helper.hpp"
 #include "leaked_ptr.hpp"
+#include "plot_fit.hpp"
+#include "plot_kernels.hpp"
+#include "plot_markers.hpp"
+#include "plot_mesh_cache.hpp"
+#include "plot_parallel.hpp"
+#include "plot_style.hpp"
+#include "value_getter.hpp"
 
 namespace py = pybind11;
 
-#define PY_BUF_IS_TYPE(__type__, __buffer_info__)                              \
-  (py::detail::compare_buffer_info<__type__>::compare(__buffer_info__))
+// Tells apart the plot functions in the mesh cache, the decimation mode is
+// added to these.
+enum MeshKind { MeshKindLine = 0, MeshKindScatter = 8, MeshKindStairs = 16 };
 
-// RAII Helper to pin buffers and template expand correct callback getter func.
-struct ValueGetter {
+// Buffers pinned for plotting over many frames. The buffers are requested and
+// their types resolved once when the data is set. Plots keep the GIL, so no
+// other thread replaces or touches the data while it is read.
+class Series {
 public:
-  explicit ValueGetter(const py::buffer& bufY)
-      : hasX(false), infoY(bufY.request()) {
-    if (this->infoY.ndim != 1) {
-      throw std::runtime_error(error_dim);
+  explicit Series(const py::buffer& ys)
+      : getter(std::make_unique<ValueGetter>(ys)) {}
+  Series(const py::buffer& xs, const py::buffer& ys)
+      : getter(std::make_unique<ValueGetter>(xs, ys)) {
+    this->getter->is_x_sorted();
+  }
+
+  void set_data(const py::buffer& ys) {
+    this->getter = std::make_unique<ValueGetter>(ys);
+    this->declaredSorted = -1;
+    ++this->version;
+  }
+  void set_data(const py::buffer& xs, const py::buffer& ys) {
+    this->getter = std::make_unique<ValueGetter>(xs, ys);
+    this->declaredSorted = -1;
+    this->getter->is_x_sorted();
+    ++this->version;
+  }
+
+  // Marks the data as modified in place.
+  void touch() {
+    this->getter->invalidate();
+    if (this->declaredSorted >= 0) {
+      this->getter->set_x_sorted(this->declaredSorted > 0);
+    } else {
+      this->getter->is_x_sorted();
     }
+    ++this->version;
+  }
+
+  // The x values are checked once whenever the data changes. A declaration
+  // replaces the check until new data is set.
+  [[nodiscard]] bool get_x_sorted() const {
+    return this->getter->is_x_sorted_cached();
   }
-  explicit ValueGetter(const py::buffer& bufX, const py::buffer& bufY)
-      : hasX(true), infoX(bufX.request()), infoY(bufY.request()) {
-    if (this->infoX.ndim != 1 || this->infoY.ndim != 1 ||
-        this->infoX.shape.at(0) != this->infoY.shape.at(0)) {
-      throw std::runtime_error(error_dim);
+  void set_x_sorted(bool sorted) {
+    this->getter->set_x_sorted(sorted);
+    this->declaredSorted = sorted ? 1 : 0;
+  }
+
+  [[nodiscard]] uint64_t get_version() const { return this->version; }
+  [[nodiscard]] ValueGetter& value_getter() { return *this->getter; }
+
+  // Opt-in, replays an item's geometry as long as the data version, plot
+  // limits, size and style stay the same.
+  [[nodiscard]] bool get_cache_meshes() const {
+    return this->meshCache != nullptr;
+  }
+  void set_cache_meshes(bool enabled) {
+    if (!enabled) {
+      this->meshCache.reset();
+    } else if (this->meshCache == nullptr) {
+      this->meshCache = std::make_unique<MeshCache>();
     }
   }
 
-  typedef ImPlotPoint getter_func(void* data, int idx);
-  [[nodiscard]] getter_func* get_getter_func() const {
-#define VG_EMIT_GET_GETTER_Y(__type__)                                         \
-  if (PY_BUF_IS_TYPE(__type__, this->infoX)) {                                 \
-    return get_getter_func_y<__type__>();                                      \
+  // Plots with plot_fn(), through the mesh cache if enabled.
+  template <typename PlotFn>
+  void plot(const char* label_id, int kind, ImPlotCol recolor_from,
+            PlotFn&& plot_fn) {
+    if (this->meshCache == nullptr) {
+      plot_fn();
+      return;
+    }
+    this->meshCache->plot(label_id, this->version, kind, recolor_from,
+                          std::forward<PlotFn>(plot_fn));
   }
 
-    if (hasX) {
-      VG_EMIT_GET_GETTER_Y(bool);
-      VG_EMIT_GET_GETTER_Y(float);
-      VG_EMIT_GET_GETTER_Y(double);
-      VG_EMIT_GET_GETTER_Y(int8_t);
-      VG_EMIT_GET_GETTER_Y(uint8_t);
-      VG_EMIT_GET_GETTER_Y(int16_t);
-      VG_EMIT_GET_GETTER_Y(uint16_t);
-      VG_EMIT_GET_GETTER_Y(int32_t);
-      VG_EMIT_GET_GETTER_Y(uint32_t);
-      VG_EMIT_GET_GETTER_Y(int64_t);
-      VG_EMIT_GET_GETTER_Y(uint64_t);
-      throw std::runtime_error(error_type);
+private:
+  std::unique_ptr<ValueGetter> getter;
+  uint64_t version = 0;
+  // -1: not declared, 0: not sorted, 1: sorted
+  int declaredSorted = -1;
+  std::unique_ptr<MeshCache> meshCache;
+};
+
+// Reduces the data to the pixel columns of the current plot. While the plot is
+// being fit, the full data range is used so ImPlot still sees the extents.
+template <typename Xs, typename Ys>
+static void decimate_visible(const Xs& xs, const Ys& ys, std::ptrdiff_t count,
+                             kernels::Decimation mode,
+                             std::vector<double>& out) {
+  thread_local std::vector<double> edges;
+  const int columns = std::max(1, static_cast<int>(ImPlot::GetPlotSize().x));
+  edges.resize(columns + 1);
+  if (ImPlot::FitThisFrame()) {
+    const double x0 = xs[0];
+    const double x1 = xs[count - 1];
+    for (int c = 0; c < columns; ++c) {
+      edges[c] = x0 + (x1 - x0) * c / columns;
+    }
+    edges[columns] = x1;
+  } else {
+    // Going through pixel space handles log scale and inverted axes
+    const float left = ImPlot::GetPlotPos().x;
+    for (int c = 0; c <= columns; ++c) {
+      edges[c] = ImPlot::PixelsToPlot(left + c, 0.0f).x;
+    }
+    if (edges.front() > edges.back()) {
+      std::reverse(edges.begin(), edges.end());
+    }
+  }
+  kernels::decimate_columns(xs, ys, count, mode, edges, out);
+}
+
+// Narrows a getter to the values inside the x limits of the current plot plus
+// one on each side, if its x values are known to be sorted. This is a binary
+// search, so zoomed in plots of long recordings only cost the visible values.
+// Not done while ImPlot scans the values to fit the plot (see CachedFit).
+class VisibleRange {
+public:
+  explicit VisibleRange(ValueGetter& value_getter)
+      : value_getter(value_getter) {
+    const auto count = value_getter.count();
+    if (count == 0 || ImPlot::FitThisFrame() ||
+        !value_getter.is_x_sorted_cached()) {
+      return;
+    }
+    const auto limits = ImPlot::GetPlotLimits().X;
+    std::ptrdiff_t first, last;
+    if (!value_getter.has_x()) {
+      first = static_cast<std::ptrdiff_t>(
+          std::clamp(std::floor(limits.Min), 0.0, static_cast<double>(count)));
+      last = static_cast<std::ptrdiff_t>(std::clamp(
+          std::ceil(limits.Max) + 1.0, 0.0, static_cast<double>(count)));
     } else {
-      return get_getter_func_y<void>();
+      value_getter.visit_x([&](const auto& xs) {
+        first = kernels::lower_bound(xs, 0, count, limits.Min);
+        last = kernels::upper_bound(xs, first, count, limits.Max);
+      });
+    }
+    first = std::max<std::ptrdiff_t>(first - 1, 0);
+    last = std::min<std::ptrdiff_t>(last + 1, count);
+    value_getter.set_range(static_cast<int>(first), static_cast<int>(last));
+  }
+  ~VisibleRange() { this->value_getter.reset_range(); }
+  VisibleRange(const VisibleRange&) = delete;
+  VisibleRange& operator=(const VisibleRange&) = delete;
+
+private:
+  ValueGetter& value_getter;
+};
+
+// Plots the decimated values with plot_fn(xs, ys, count, stride) if a
+// decimation mode is selected. Returns false if nothing was plotted, e.g.
+// because the x values are not sorted. Buffers passed for a single call are
+// not checked value by value, only their first and last x.
+template <typename PlotFn>
+static bool plot_decimated(ValueGetter& value_getter, kernels::Decimation mode,
+                           PlotFn&& plot_fn) {
+  const auto count = value_getter.count();
+  if (mode == kernels::Decimation::None || count == 0 ||
+      value_getter.is_x_unsorted_cached()) {
+    return false;
+  }
+  thread_local std::vector<double> points;
+  bool decimated = false;
+  value_getter.visit_x([&](const auto& xs) {
+    if (!value_getter.is_x_sorted_cached() && xs[count - 1] < xs[0]) {
+      return;
     }
-#undef VG_EMIT_GET_GETTER_Y
+    value_getter.visit_y([&](const auto& ys) {
+      decimate_visible(xs, ys, count, mode, points);
+    });
+    decimated = true;
+  });
+  if (!decimated) {
+    return false;
+  }
+  plot_fn(points.data(), points.data() + 1,
+          static_cast<int>(points.size() / 2),
+          static_cast<int>(2 * sizeof(double)));
+  return true;
+}
+
+// Calls fn(getter, count) with a getter(idx) returning the ImPlotPoint at
+// idx, typed for the value layout if possible.
+template <typename Fn>
+static void visit_points(const ValueGetter& value_getter, Fn&& fn) {
+  auto visit_y = [&](const auto* y_ptr, int count, int stride) {
+    const double x0 = value_getter.range_first();
+    const auto* ys = reinterpret_cast<const char*>(y_ptr);
+    using T = std::remove_cv_t<std::remove_pointer_t<decltype(y_ptr)>>;
+    fn(
+        [=](int idx) {
+          const auto offset = std::ptrdiff_t{idx} * stride;
+          return ImPlotPoint(x0 + idx,
+                             *reinterpret_cast<const T*>(ys + offset));
+        },
+        count);
+  };
+  auto visit_xy = [&](const auto* x_ptr, const auto* y_ptr, int count,
+                      int stride) {
+    const auto* xs = reinterpret_cast<const char*>(x_ptr);
+    const auto* ys = reinterpret_cast<const char*>(y_ptr);
+    using T = std::remove_cv_t<std::remove_pointer_t<decltype(y_ptr)>>;
+    fn(
+        [=](int idx) {
+          const auto offset = std::ptrdiff_t{idx} * stride;
+          return ImPlotPoint(*reinterpret_cast<const T*>(xs + offset),
+                             *reinterpret_cast<const T*>(ys + offset));
+        },
+        count);
+  };
+  if (!value_getter.visit_typed(visit_y, visit_xy)) {
+    auto getter = value_getter.get_getter_func();
+    auto* data = const_cast<ValueGetter*>(&value_getter);
+    fn([=](int idx) { return getter(data, idx); }, value_getter.count());
+  }
+}
+
+// Worker pool tessellating large line plots, see set_render_threads().
+static std::unique_ptr<WorkerPool> renderPool;
+static int renderMinCount = 1000000;
+
+// Plots the line on the render pool if it is enabled, the line is long enough
+// and ImPlot would tessellate it the same way. Returns false if not plotted.
+static bool plot_line_pooled(const char* label_id,
+                             const ValueGetter& value_getter) {
+  if (renderPool == nullptr || value_getter.count() < renderMinCount ||
+      !can_plot_line_parallel()) {
+    return false;
+  }
+  visit_points(value_getter, [&](const auto& getter, int count) {
+    plot_line_parallel(*renderPool, label_id, getter, count);
+  });
+  return true;
+}
+
+// Copies scatter markers from a template, see set_fast_markers().
+static bool fastMarkers = false;
+
+// Plots the scatter with plot_scatter_fast() if fast markers are enabled.
+// Returns false if not plotted.
+static bool plot_scatter_templated(const char* label_id,
+                                   const ValueGetter& value_getter) {
+  if (!fastMarkers) {
+    return false;
   }
+  bool plotted = false;
+  visit_points(value_getter, [&](const auto& getter, int count) {
+    plotted = plot_scatter_fast(label_id, getter, count);
+  });
+  return plotted;
+}
 
-  [[nodiscard]] int count() const {
-    auto count = this->infoY.shape.at(0);
-    assert(count >= 0);
-    assert(count <= std::numeric_limits<int>::max());
-    return static_cast<int>(count);
+static void plot_line_values(const char* label_id, ValueGetter& value_getter,
+                             kernels::Decimation decimation) {
+  CachedFit fit(label_id, [&]() -> const ImPlotLimits& {
+    return value_getter.extents();
+  });
+  VisibleRange visible_range(value_getter);
+  auto plot_y = [&](const auto* y_ptr, int count, int stride) {
+    ImPlot::PlotLine(label_id, y_ptr, count, 1, value_getter.range_first(),
+                     0, stride);
+  };
+  auto plot_xy = [&](const auto* x_ptr, const auto* y_ptr, int count,
+                     int stride) {
+    ImPlot::PlotLine(label_id, x_ptr, y_ptr, count, 0, stride);
   };
+  if (plot_decimated(value_getter, decimation, plot_xy) ||
+      plot_line_pooled(label_id, value_getter) ||
+      value_getter.visit_typed(plot_y, plot_xy)) {
+    return;
+  }
+  ImPlot::PlotLineG(label_id, value_getter.get_getter_func(), &value_getter,
+                    value_getter.count());
+}
 
-protected:
-  static const constexpr char* error_dim = "Incompatible buffer dimension!";
-  static const constexpr char* error_type =
-      "Incompatible format: expected array of bool, float, double or "
-      "unsigned/signed int 8, 16, 32 or 64!";
+static void plot_scatter_values(const char* label_id,
+                                ValueGetter& value_getter) {
+  CachedFit fit(label_id, [&]() -> const ImPlotLimits& {
+    return value_getter.extents();
+  });
+  VisibleRange visible_range(value_getter);
+  auto plot_y = [&](const auto* y_ptr, int count, int stride) {
+    ImPlot::PlotScatter(label_id, y_ptr, count, 1, value_getter.range_first(),
+                        0, stride);
+  };
+  auto plot_xy = [&](const auto* x_ptr, const auto* y_ptr, int count,
+                     int stride) {
+    ImPlot::PlotScatter(label_id, x_ptr, y_ptr, count, 0, stride);
+  };
+  if (plot_scatter_templated(label_id, value_getter) ||
+      value_getter.visit_typed(plot_y, plot_xy)) {
+    return;
+  }
+  ImPlot::PlotScatterG(label_id, value_getter.get_getter_func(),
+                       &value_getter, value_getter.count());
+}
 
-  template <typename X, typename Y>
+static void plot_stairs_values(const char* label_id, ValueGetter& value_getter,
+                               kernels::Decimation decimation) {
+  CachedFit fit(label_id, [&]() -> const ImPlotLimits& {
+    return value_getter.extents();
+  });
+  VisibleRange visible_range(value_getter);
+  auto plot_y = [&](const auto* y_ptr, int count, int stride) {
+    ImPlot::PlotStairs(label_id, y_ptr, count, 1, value_getter.range_first(),
+                       0, stride);
+  };
+  auto plot_xy = [&](const auto* x_ptr, const auto* y_ptr, int count,
+                     int stride) {
+    ImPlot::PlotStairs(label_id, x_ptr, y_ptr, count, 0, stride);
+  };
+  if (plot_decimated(value_getter, decimation, plot_xy) ||
+      value_getter.visit_typed(plot_y, plot_xy)) {
+    return;
+  }
+  ImPlot::PlotStairsG(label_id, value_getter.get_getter_func(), &value_getter,
+                      value_getter.count());
+}
+
+// Getter for one series of a 2D buffer. The shared x values are converted to
+// double once for all series.
+struct SeriesRowGetter {
+  const double* xs;
+  const char* ys;
+  py::ssize_t stride;
+
+  template <typename Y, bool Swap>
   static ImPlotPoint getValue(void* data, int idx) {
-    const auto* this_ = static_cast<ValueGetter*>(data);
-    double x, y;
-    if constexpr (std::is_void<X>::value) {
-      x = static_cast<double>(idx);
-    } else {
-      x = static_cast<double>((static_cast<X*>(this_->infoX.ptr))[idx]);
-    }
-    y = static_cast<double>((static_cast<Y*>(this_->infoY.ptr))[idx]);
-    return ImPlotPoint(x, y);
+    const auto* this_ = static_cast<SeriesRowGetter*>(data);
+    return ImPlotPoint(this_->xs[idx],
+                       load_value<Y, Swap>(this_->ys + idx * this_->stride));
   }
+};
 
-  template <typename X>
-  [[nodiscard]] inline getter_func* get_getter_func_y() const {
-#define VG_EMIT_RET_GETTER(__type__)                                           \
-  if (PY_BUF_IS_TYPE(__type__, this->infoY)) {                                 \
-    return &getValue<X, __type__>;                                             \
+// Plots every row (or column if interleaved) of a 2D buffer as a line. xs may
+// be null, in which case the index is used.
+static void plot_lines_2d_values(const std::vector<std::string>& labels,
+                                 const py::buffer* xs, const py::buffer& values,
+                                 bool interleaved,
+                                 const std::vector<ImVec4>& colors,
+                                 const std::vector<float>& weights) {
+  const auto info = values.request();
+  if (info.ndim != 2) {
+    throw std::runtime_error("Incompatible buffer dimension!");
+  }
+  const int series_axis = interleaved ? 1 : 0;
+  const auto series_count = static_cast<size_t>(info.shape[series_axis]);
+  const auto series_stride = info.strides[series_axis];
+  const auto stride = info.strides[1 - series_axis];
+  const auto count = info.shape[1 - series_axis];
+  if (count > std::numeric_limits<int>::max()) {
+    throw std::runtime_error("Too many values!");
+  }
+  if (labels.size() != series_count ||
+      (!colors.empty() && colors.size() != series_count) ||
+      (!weights.empty() && weights.size() != series_count)) {
+    throw std::invalid_argument(
+        "Labels, colors and weights must match the number of series!");
+  }
+  const auto type = ValueGetter::resolve_value_type(info);
+  const bool swapped = ValueGetter::is_byte_swapped(info);
+  const bool typed = ValueGetter::has_implot_type(type, swapped) &&
+                     ValueGetter::is_implot_stride(stride);
+
+  // The x values are shared, so work out once how all series are plotted:
+  // uniformly spaced xs map to ImPlot's xscale/x0, xs matching the values'
+  // type and stride are passed as they are, anything else is converted.
+  py::buffer_info infoX;
+  bool uniform = xs == nullptr;
+  bool typed_xy = false;
+  double x0 = 0.0, dx = 1.0;
+  thread_local std::vector<double> x_scratch;
+  if (xs != nullptr) {
+    infoX = xs->request();
+    if (infoX.ndim != 1 || infoX.shape.at(0) != count) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+    const auto typeX = ValueGetter::resolve_value_type(infoX);
+    visit_column(infoX, typeX, 0, [&](const auto& x_values) {
+      uniform = kernels::is_uniform(x_values, count, x0, dx);
+      typed_xy = typeX == type && !ValueGetter::is_byte_swapped(infoX) &&
+                 infoX.strides.at(0) == stride;
+      if (!typed || (!uniform && !typed_xy)) {
+        x_scratch.resize(count);
+        for (py::ssize_t i = 0; i < count; ++i) {
+          x_scratch[i] = x_values[i];
+        }
+      }
+    });
+  } else if (!typed) {
+    x_scratch.resize(count);
+    for (py::ssize_t i = 0; i < count; ++i) {
+      x_scratch[i] = static_cast<double>(i);
+    }
   }
 
-    VG_EMIT_RET_GETTER(bool);
-    VG_EMIT_RET_GETTER(float);
-    VG_EMIT_RET_GETTER(double);
-    VG_EMIT_RET_GETTER(int8_t);
-    VG_EMIT_RET_GETTER(uint8_t);
-    VG_EMIT_RET_GETTER(int16_t);
-    VG_EMIT_RET_GETTER(uint16_t);
-    VG_EMIT_RET_GETTER(int32_t);
-    VG_EMIT_RET_GETTER(uint32_t);
-    VG_EMIT_RET_GETTER(int64_t);
-    VG_EMIT_RET_GETTER(uint64_t);
-    throw std::runtime_error(error_type);
-#undef VG_EMIT_RET_GETTER
+  py::gil_scoped_release release;
+  for (size_t s = 0; s < series_count; ++s) {
+    ImPlot::SetNextLineStyle(colors.empty() ? IMPLOT_AUTO_COL : colors[s],
+                             weights.empty() ? IMPLOT_AUTO : weights[s]);
+    const char* label_id = labels[s].c_str();
+    const char* ys = static_cast<const char*>(info.ptr) + s * series_stride;
+    dispatch_value_type(type, [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      if constexpr (is_implot_value<T>) {
+        using IT = implot_type<T>;
+        if (typed && uniform) {
+          ImPlot::PlotLine(label_id, reinterpret_cast<const IT*>(ys),
+                           static_cast<int>(count), dx, x0, 0,
+                           static_cast<int>(stride));
+          return;
+        }
+        if (typed && typed_xy) {
+          ImPlot::PlotLine(label_id, static_cast<const IT*>(infoX.ptr),
+                           reinterpret_cast<const IT*>(ys),
+                           static_cast<int>(count), 0,
+                           static_cast<int>(stride));
+          return;
+        }
+      }
+      SeriesRowGetter getter{x_scratch.data(), ys, stride};
+      ImPlot::PlotLineG(label_id,
+                        swapped ? &SeriesRowGetter::getValue<T, true>
+                                : &SeriesRowGetter::getValue<T, false>,
+                        &getter, static_cast<int>(count));
+    });
   }
+}
 
-private:
-  const bool hasX;
-  const py::buffer_info infoX;
-  const py::buffer_info infoY;
+// Getter for the horizontal reference of plot_shaded. Shares the x values of
+// the line's getter.
+struct ReferenceGetter {
+  ValueGetter* line;
+  double y_ref;
+
+  static ImPlotPoint getValue(void* data, int idx) {
+    const auto* this_ = static_cast<ReferenceGetter*>(data);
+    auto point = this_->line->get_getter_func()(this_->line, idx);
+    point.y = this_->y_ref;
+    return point;
+  }
 };
 
+template <size_t N>
+static void plot_error_bars_values(const char* label_id,
+                                   BufferGroup<N>& buffers, bool horizontal) {
+  py::gil_scoped_release release;
+  buffers.visit([&](const auto& ptrs, int stride) {
+    if constexpr (N == 3) {
+      if (horizontal) {
+        ImPlot::PlotErrorBarsH(label_id, ptrs[0], ptrs[1], ptrs[2],
+                               buffers.count(), 0, stride);
+      } else {
+        ImPlot::PlotErrorBars(label_id, ptrs[0], ptrs[1], ptrs[2],
+                              buffers.count(), 0, stride);
+      }
+    } else {
+      if (horizontal) {
+        ImPlot::PlotErrorBarsH(label_id, ptrs[0], ptrs[1], ptrs[2], ptrs[3],
+                               buffers.count(), 0, stride);
+      } else {
+        ImPlot::PlotErrorBars(label_id, ptrs[0], ptrs[1], ptrs[2], ptrs[3],
+                              buffers.count(), 0, stride);
+      }
+    }
+  });
+}
+
+// Plots a 2D buffer as heatmap. ImPlot expects packed row-major values, so
+// anything else (and bool) is converted to double first.
+static void plot_heatmap_values(const char* label_id, const py::buffer& values,
+                                double scale_min, double scale_max,
+                                const char* label_fmt,
+                                const ImPlotPoint& bounds_min,
+                                const ImPlotPoint& bounds_max) {
+  const auto info = values.request();
+  if (info.ndim != 2) {
+    throw std::runtime_error("Incompatible buffer dimension!");
+  }
+  const auto rows = info.shape[0];
+  const auto cols = info.shape[1];
+  if (rows > std::numeric_limits<int>::max() ||
+      cols > std::numeric_limits<int>::max() ||
+      rows * cols > std::numeric_limits<int>::max()) {
+    throw std::runtime_error("Too many values!");
+  }
+  const auto type = ValueGetter::resolve_value_type(info);
+  const bool packed = info.strides[1] == info.itemsize &&
+                      info.strides[0] == info.itemsize * cols;
+
+  py::gil_scoped_release release;
+  if (packed &&
+      ValueGetter::has_implot_type(type, ValueGetter::is_byte_swapped(info))) {
+    dispatch_value_type(type, [&](auto tag) {
+      using T = implot_type<typename decltype(tag)::type>;
+      if constexpr (is_implot_value<T>) {
+        ImPlot::PlotHeatmap(label_id, static_cast<const T*>(info.ptr),
+                            static_cast<int>(rows), static_cast<int>(cols),
+                            scale_min, scale_max, label_fmt, bounds_min,
+                            bounds_max);
+      }
+    });
+    return;
+  }
+  thread_local std::vector<double> scratch;
+  scratch.resize(rows * cols);
+  for (py::ssize_t col = 0; col < cols; ++col) {
+    visit_column(info, type, col, [&](const auto& column) {
+      for (py::ssize_t row = 0; row < rows; ++row) {
+        scratch[row * cols + col] = column[row];
+      }
+    });
+  }
+  ImPlot::PlotHeatmap(label_id, scratch.data(), static_cast<int>(rows),
+                      static_cast<int>(cols), scale_min, scale_max, label_fmt,
+                      bounds_min, bounds_max);
+}
+
+// Limits shared by the axes linked to a group, see link_next_plot_limits().
+// ImPlot keeps pointers to them from BeginPlot() to EndPlot(), map nodes
+// never move.
+static std::unordered_map<std::string, ImPlotRange> linkedLimits;
+
+// Returns the limits of a group, created with ImPlot's default range.
+static ImPlotRange* linked_range(const char* group) {
+  if (group == nullptr) {
+    return nullptr;
+  }
+  return &linkedLimits.try_emplace(group, 0.0, 1.0).first->second;
+}
+
 void py_init_module_implot(py::module& m) {
 
   py::enum_<ImPlotFlags_>(m, "Flags", py::arithmetic(), "Options for plots.")
@@ -387,6 +833,19 @@ void py_init_module_implot(py::module& m) {
       .value("y2", ImPlotYAxis_2, "first on right side")
       .value("y3", ImPlotYAxis_3, "second on right side");
 
+  py::enum_<kernels::Decimation>(
+      m, "Decimation",
+      "Data reduction applied to line plots before rendering. The x values "
+      "must be sorted. Series plot every point if they are not, other "
+      "buffers only if their last x is less than their first.")
+      // None is a keyword in Python
+      .value("None_", kernels::Decimation::None, "plot every point")
+      .value("M4", kernels::Decimation::M4,
+             "keep the first, last, minimum and maximum point of every pixel "
+             "column")
+      .value("LTTB", kernels::Decimation::LTTB,
+             "largest triangle three buckets, two points per pixel column");
+
   py::class_<ImPlotPoint>(m, "Point",
                           "Double precision version of ImVec2 used by ImPlot.")
       .def(py::init<>())
@@ -508,6 +967,56 @@ void py_init_module_implot(py::module& m) {
       .def_readwrite("use_24_hour_clock", &ImPlotStyle::Use24HourClock,
                      "times will be formatted using a 24 hour clock");
 
+  py::class_<ItemStyle>(
+      m, "ItemStyle",
+      "Reusable style of a single item. Pass it as the style argument of a "
+      "plot function instead of pushing and popping style colors and "
+      "variables around the item. IMPLOT_AUTO and IMPLOT_AUTO_COL keep the "
+      "current style.")
+      .def(py::init([](const ImVec4& line_color, float line_weight,
+                       const ImVec4& fill_color, float fill_alpha,
+                       ImPlotMarker marker, float marker_size,
+                       const ImVec4& marker_fill, float marker_weight,
+                       const ImVec4& marker_outline,
+                       const ImVec4& error_bar_color, float error_bar_size,
+                       float error_bar_weight) {
+             return ItemStyle{line_color,      line_weight,   fill_color,
+                              fill_alpha,      marker,        marker_size,
+                              marker_fill,     marker_weight, marker_outline,
+                              error_bar_color, error_bar_size,
+                              error_bar_weight};
+           }),
+           py::arg("line_color") = IMPLOT_AUTO_COL,
+           py::arg("line_weight") = IMPLOT_AUTO,
+           py::arg("fill_color") = IMPLOT_AUTO_COL,
+           py::arg("fill_alpha") = IMPLOT_AUTO,
+           py::arg("marker") = IMPLOT_AUTO,
+           py::arg("marker_size") = IMPLOT_AUTO,
+           py::arg("marker_fill") = IMPLOT_AUTO_COL,
+           py::arg("marker_weight") = IMPLOT_AUTO,
+           py::arg("marker_outline") = IMPLOT_AUTO_COL,
+           py::arg("error_bar_color") = IMPLOT_AUTO_COL,
+           py::arg("error_bar_size") = IMPLOT_AUTO,
+           py::arg("error_bar_weight") = IMPLOT_AUTO)
+      .def_readwrite("line_color", &ItemStyle::lineColor)
+      .def_readwrite("line_weight", &ItemStyle::lineWeight,
+                     "line weight in pixels")
+      .def_readwrite("fill_color", &ItemStyle::fillColor)
+      .def_readwrite("fill_alpha", &ItemStyle::fillAlpha,
+                     "alpha modifier applied to the fill")
+      .def_readwrite("marker", &ItemStyle::marker, "marker specification")
+      .def_readwrite("marker_size", &ItemStyle::markerSize,
+                     "marker size in pixels (roughly the marker's \"radius\")")
+      .def_readwrite("marker_fill", &ItemStyle::markerFill)
+      .def_readwrite("marker_weight", &ItemStyle::markerWeight,
+                     "outline weight of markers in pixels")
+      .def_readwrite("marker_outline", &ItemStyle::markerOutline)
+      .def_readwrite("error_bar_color", &ItemStyle::errorBarColor)
+      .def_readwrite("error_bar_size", &ItemStyle::errorBarSize,
+                     "error bar whisker width in pixels")
+      .def_readwrite("error_bar_weight", &ItemStyle::errorBarWeight,
+                     "error bar whisker weight in pixels");
+
   // TODO ImPlotInputMap is not available for now.
 
   m.def("begin_plot", &ImPlot::BeginPlot, py::arg("title_id"),
@@ -531,161 +1040,427 @@ void py_init_module_implot(py::module& m) {
   // Plot Items
   //---------------------------------------------------------------------------
 
+  py::class_<Series>(
+      m, "Series",
+      "Buffers pinned for plotting over many frames. Buffer requests and type "
+      "dispatch happen once when the data is set instead of on every plot "
+      "call. Call touch() after modifying the data in place.")
+      .def(py::init<const py::buffer&>(), py::arg("values"))
+      .def(py::init<const py::buffer&, const py::buffer&>(), py::arg("xs"),
+           py::arg("ys"))
+      .def("set_data",
+           py::overload_cast<const py::buffer&>(&Series::set_data),
+           py::arg("values"), "Replaces the plotted buffer.")
+      .def("set_data",
+           py::overload_cast<const py::buffer&, const py::buffer&>(
+               &Series::set_data),
+           py::arg("xs"), py::arg("ys"), "Replaces the plotted buffers.")
+      .def("touch", &Series::touch,
+           "Marks the data as modified in place and increments the version.")
+      .def_property_readonly("version", &Series::get_version,
+                             "incremented whenever the data changes")
+      .def_property("cache_meshes", &Series::get_cache_meshes,
+                    &Series::set_cache_meshes,
+                    "whether plots of the series replay the geometry of an "
+                    "earlier frame while the version, plot limits, size and "
+                    "style are unchanged. Off by default.")
+      .def_property("x_sorted", &Series::get_x_sorted, &Series::set_x_sorted,
+                    "whether xs are sorted ascending, which lets plots skip "
+                    "the values outside the x limits. Checked once whenever "
+                    "the data changes. A value set here is trusted instead "
+                    "until set_data() is called, declaring unsorted data "
+                    "sorted hides values.")
+      .def("__len__",
+           [](Series& self) { return self.value_getter().size(); });
+
   m.def(
       "plot_line",
-      [](const char* label_id, const py::buffer& values) {
+      [](const char* label_id, const py::buffer& values,
+         kernels::Decimation decimation, const ItemStyle* style) {
         auto value_getter = ValueGetter(values);
         py::gil_scoped_release release;
-        ImPlot::PlotLineG(label_id, value_getter.get_getter_func(),
-                          &value_getter, value_getter.count());
+        apply_style(style);
+        plot_line_values(label_id, value_getter, decimation);
       },
-      py::arg("label_id"), py::arg("values"), "Plots a standard 2D line plot.");
+      py::arg("label_id"), py::arg("values"),
+      py::arg("decimation") = kernels::Decimation::None,
+      py::arg("style") = nullptr,
+      "Plots a standard 2D line plot. #decimation reduces the data to what "
+      "the current plot width can show.");
   m.def(
       "plot_line",
-      [](const char* label_id, const py::buffer& xs, const py::buffer& ys) {
+      [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
+         kernels::Decimation decimation, const ItemStyle* style) {
         auto value_getter = ValueGetter(xs, ys);
         py::gil_scoped_release release;
-        ImPlot::PlotLineG(label_id, value_getter.get_getter_func(),
-                          &value_getter, value_getter.count());
+        apply_style(style);
+        plot_line_values(label_id, value_getter, decimation);
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys"),
-      "Plots a standard 2D line plot.");
+      py::arg("decimation") = kernels::Decimation::None,
+      py::arg("style") = nullptr,
+      "Plots a standard 2D line plot. #decimation reduces the data to what "
+      "the current plot width can show (xs must be sorted).");
+  m.def(
+      "plot_line",
+      [](const char* label_id, Series& series, kernels::Decimation decimation,
+         const ItemStyle* style) {
+        apply_style(style);
+        series.plot(label_id, MeshKindLine + static_cast<int>(decimation),
+                    ImPlotCol_Line, [&]() {
+                      plot_line_values(label_id, series.value_getter(),
+                                       decimation);
+                    });
+      },
+      py::arg("label_id"), py::arg("series"),
+      py::arg("decimation") = kernels::Decimation::None,
+      py::arg("style") = nullptr,
+      "Plots a standard 2D line plot. #decimation reduces the data to what "
+      "the current plot width can show (xs must be sorted).");
+  m.def(
+      "set_render_threads",
+      [](int threads, int min_count) {
+        if (threads < 0 || min_count < 2) {
+          throw std::invalid_argument("Invalid thread or point count!");
+        }
+        if (threads == 0) {
+          threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        renderPool.reset();
+        if (threads > 1) {
+          renderPool = std::make_unique<WorkerPool>(threads);
+        }
+        renderMinCount = min_count;
+      },
+      py::arg("threads"), py::arg("min_count") = 1000000,
+      "Tessellates line plots of at least #min_count points on #threads "
+      "threads (0 uses all cores). The default of 1 thread leaves all plots "
+      "to ImPlot. Anti-aliased lines and lines with markers are not split. "
+      "Call from the render thread.");
+  m.def(
+      "get_render_threads",
+      []() { return renderPool != nullptr ? renderPool->size() : 1; },
+      "Number of threads tessellating large line plots.");
+  m.def(
+      "set_fast_markers", [](bool enabled) { fastMarkers = enabled; },
+      py::arg("enabled"),
+      "Draws scatter markers by copying the first one instead of "
+      "tessellating each, markers of a couple of pixels as single quads, and "
+      "skips points on a pixel that already has a marker. Series scatter "
+      "plots are not mesh cached while enabled. Off by default.");
+  m.def(
+      "get_fast_markers", []() { return fastMarkers; },
+      "Whether scatter markers are copied from a template.");
 
   m.def(
       "plot_scatter",
-      [](const char* label_id, const py::buffer& values) {
+      [](const char* label_id, const py::buffer& values,
+         const ItemStyle* style) {
         auto value_getter = ValueGetter(values);
         py::gil_scoped_release release;
-        ImPlot::PlotScatterG(label_id, value_getter.get_getter_func(),
-                             &value_getter, value_getter.count());
+        apply_style(style);
+        plot_scatter_values(label_id, value_getter);
       },
-      py::arg("label_id"), py::arg("values"),
+      py::arg("label_id"), py::arg("values"), py::arg("style") = nullptr,
       "Plots a standard 2D scatter plot. Default marker is "
       "ImPlotMarker_Circle.");
   m.def(
       "plot_scatter",
-      [](const char* label_id, const py::buffer& xs, const py::buffer& ys) {
+      [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
+         const ItemStyle* style) {
         auto value_getter = ValueGetter(xs, ys);
         py::gil_scoped_release release;
-        ImPlot::PlotScatterG(label_id, value_getter.get_getter_func(),
-                             &value_getter, value_getter.count());
+        apply_style(style);
+        plot_scatter_values(label_id, value_getter);
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys"),
+      py::arg("style") = nullptr,
+      "Plots a standard 2D scatter plot. Default marker is "
+      "ImPlotMarker_Circle.");
+  m.def(
+      "plot_scatter",
+      [](const char* label_id, Series& series, const ItemStyle* style) {
+        apply_style(style);
+        auto plot_fn = [&]() {
+          plot_scatter_values(label_id, series.value_getter());
+        };
+        // Fast markers push their own clip rect, a replay would lose it. Only
+        // geometry plotted without them is cached, so toggling them never
+        // replays the other kind.
+        if (fastMarkers) {
+          plot_fn();
+        } else {
+          series.plot(label_id, MeshKindScatter, ImPlotCol_MarkerOutline,
+                      plot_fn);
+        }
+      },
+      py::arg("label_id"), py::arg("series"), py::arg("style") = nullptr,
       "Plots a standard 2D scatter plot. Default marker is "
       "ImPlotMarker_Circle.");
 
   m.def(
       "plot_stairs",
-      [](const char* label_id, const py::buffer& values) {
+      [](const char* label_id, const py::buffer& values,
+         kernels::Decimation decimation, const ItemStyle* style) {
         auto value_getter = ValueGetter(values);
         py::gil_scoped_release release;
-        ImPlot::PlotStairsG(label_id, value_getter.get_getter_func(),
-                            &value_getter, value_getter.count());
+        apply_style(style);
+        plot_stairs_values(label_id, value_getter, decimation);
       },
       py::arg("label_id"), py::arg("values"),
+      py::arg("decimation") = kernels::Decimation::None,
+      py::arg("style") = nullptr,
       "Plots a a stairstep graph. The y value is continued constantly from "
-      "every x position, i.e. the interval [x[i], x[i+1]) has the value y[i].");
+      "every x position, i.e. the interval [x[i], x[i+1]) has the value y[i]. "
+      "#decimation reduces the data to what the current plot width can show.");
   m.def(
       "plot_stairs",
-      [](const char* label_id, const py::buffer& xs, const py::buffer& ys) {
+      [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
+         kernels::Decimation decimation, const ItemStyle* style) {
         auto value_getter = ValueGetter(xs, ys);
         py::gil_scoped_release release;
-        ImPlot::PlotStairsG(label_id, value_getter.get_getter_func(),
-                            &value_getter, value_getter.count());
+        apply_style(style);
+        plot_stairs_values(label_id, value_getter, decimation);
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys"),
+      py::arg("decimation") = kernels::Decimation::None,
+      py::arg("style") = nullptr,
+      "Plots a a stairstep graph. The y value is continued constantly from "
+      "every x position, i.e. the interval [x[i], x[i+1]) has the value y[i]. "
+      "#decimation reduces the data to what the current plot width can show "
+      "(xs must be sorted).");
+  m.def(
+      "plot_stairs",
+      [](const char* label_id, Series& series, kernels::Decimation decimation,
+         const ItemStyle* style) {
+        apply_style(style);
+        series.plot(label_id, MeshKindStairs + static_cast<int>(decimation),
+                    ImPlotCol_Line, [&]() {
+                      plot_stairs_values(label_id, series.value_getter(),
+                                         decimation);
+                    });
+      },
+      py::arg("label_id"), py::arg("series"),
+      py::arg("decimation") = kernels::Decimation::None,
+      py::arg("style") = nullptr,
       "Plots a a stairstep graph. The y value is continued constantly from "
-      "every x position, i.e. the interval [x[i], x[i+1]) has the value y[i].");
+      "every x position, i.e. the interval [x[i], x[i+1]) has the value y[i]. "
+      "#decimation reduces the data to what the current plot width can show "
+      "(xs must be sorted).");
+
+  m.def(
+      "plot_lines_2d",
+      [](const std::vector<std::string>& labels, const py::buffer& values,
+         const std::vector<ImVec4>& colors, const std::vector<float>& weights) {
+        plot_lines_2d_values(labels, nullptr, values, false, colors, weights);
+      },
+      py::arg("labels"), py::arg("values"),
+      py::arg("colors") = std::vector<ImVec4>(),
+      py::arg("weights") = std::vector<float>(),
+      "Plots every row of a 2D buffer as a line in a single call. #colors and "
+      "#weights are optional and set per line.");
+  m.def(
+      "plot_lines_2d",
+      [](const std::vector<std::string>& labels, const py::buffer& xs,
+         const py::buffer& values, const std::vector<ImVec4>& colors,
+         const std::vector<float>& weights) {
+        plot_lines_2d_values(labels, &xs, values, false, colors, weights);
+      },
+      py::arg("labels"), py::arg("xs"), py::arg("values"),
+      py::arg("colors") = std::vector<ImVec4>(),
+      py::arg("weights") = std::vector<float>(),
+      "Plots every row of a 2D buffer against the shared #xs as a line in a "
+      "single call. #colors and #weights are optional and set per line.");
+  m.def(
+      "plot_lines_interleaved",
+      [](const std::vector<std::string>& labels, const py::buffer& values,
+         const std::vector<ImVec4>& colors, const std::vector<float>& weights) {
+        plot_lines_2d_values(labels, nullptr, values, true, colors, weights);
+      },
+      py::arg("labels"), py::arg("values"),
+      py::arg("colors") = std::vector<ImVec4>(),
+      py::arg("weights") = std::vector<float>(),
+      "Plots every column of a 2D buffer (i.e. interleaved channels) as a "
+      "line in a single call. #colors and #weights are optional and set per "
+      "line.");
+  m.def(
+      "plot_lines_interleaved",
+      [](const std::vector<std::string>& labels, const py::buffer& xs,
+         const py::buffer& values, const std::vector<ImVec4>& colors,
+         const std::vector<float>& weights) {
+        plot_lines_2d_values(labels, &xs, values, true, colors, weights);
+      },
+      py::arg("labels"), py::arg("xs"), py::arg("values"),
+      py::arg("colors") = std::vector<ImVec4>(),
+      py::arg("weights") = std::vector<float>(),
+      "Plots every column of a 2D buffer (i.e. interleaved channels) against "
+      "the shared #xs as a line in a single call. #colors and #weights are "
+      "optional and set per line.");
 
   m.def(
       "plot_shaded",
       [](const char* label_id, const py::buffer& xs, const py::buffer& ys1,
-         const py::buffer& ys2) {
-        // TODO
-        throw std::runtime_error("not implemented");
+         const py::buffer& ys2, const ItemStyle* style) {
+        auto getter1 = ValueGetter(xs, ys1);
+        auto getter2 = ValueGetter(xs, ys2);
+        py::gil_scoped_release release;
+        apply_style(style);
+        ImPlot::PlotShadedG(label_id, getter1.get_getter_func(), &getter1,
+                            getter2.get_getter_func(), &getter2,
+                            getter1.count());
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys1"), py::arg("ys2"),
+      py::arg("style") = nullptr,
       "Plots a shaded (filled) region between two lines, or a line and a "
       "horizontal reference.");
   m.def(
       "plot_shaded",
       [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
-         double y_ref) {
-        // TODO
-        throw std::runtime_error("not implemented");
+         double y_ref, const ItemStyle* style) {
+        auto line = ValueGetter(xs, ys);
+        ReferenceGetter reference{&line, y_ref};
+        py::gil_scoped_release release;
+        apply_style(style);
+        ImPlot::PlotShadedG(label_id, line.get_getter_func(), &line,
+                            &ReferenceGetter::getValue, &reference,
+                            line.count());
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys"), py::arg("y_ref") = 0.0,
+      py::arg("style") = nullptr,
       "Plots a shaded (filled) region between two lines, or a line and a "
       "horizontal reference.");
 
   m.def(
       "plot_bars",
-      [](const char* label_id, const py::buffer& values, double width) {
+      [](const char* label_id, const py::buffer& values, double width,
+         const ItemStyle* style) {
         auto value_getter = ValueGetter(values);
         py::gil_scoped_release release;
+        apply_style(style);
         ImPlot::PlotBarsG(label_id, value_getter.get_getter_func(),
                           &value_getter, value_getter.count(), width);
       },
       py::arg("label_id"), py::arg("values"), py::arg("width") = 0.67,
+      py::arg("style") = nullptr,
       "Plots a vertical bar graph. #width and #shift are in X units.");
 
   m.def(
       "plot_bars_h",
-      [](const char* label_id, const py::buffer& values, double height) {
+      [](const char* label_id, const py::buffer& values, double height,
+         const ItemStyle* style) {
         auto value_getter = ValueGetter(values);
         py::gil_scoped_release release;
+        apply_style(style);
         ImPlot::PlotBarsHG(label_id, value_getter.get_getter_func(),
                            &value_getter, value_getter.count(), height);
       },
       py::arg("label_id"), py::arg("values"), py::arg("height") = 0.67,
+      py::arg("style") = nullptr,
       "Plots a horizontal bar graph. #height and #shift are in Y units.");
 
   m.def(
       "plot_error_bars",
       [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
-         const py::buffer& neg, const py::buffer& pos) {
-        // TODO implement ValueGetter for 4 components
-        throw std::runtime_error("not implemented");
+         const py::buffer& err, const ItemStyle* style) {
+        BufferGroup<3> buffers({&xs, &ys, &err});
+        apply_style(style);
+        plot_error_bars_values(label_id, buffers, false);
+      },
+      py::arg("label_id"), py::arg("xs"), py::arg("ys"), py::arg("err"),
+      py::arg("style") = nullptr,
+      "Plots vertical error bars of symmetric size #err. The label_id should "
+      "be the same as the label_id of the associated line or bar plot.");
+  m.def(
+      "plot_error_bars",
+      [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
+         const py::buffer& neg, const py::buffer& pos, const ItemStyle* style) {
+        BufferGroup<4> buffers({&xs, &ys, &neg, &pos});
+        apply_style(style);
+        plot_error_bars_values(label_id, buffers, false);
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys"), py::arg("neg"),
-      py::arg("pos"),
+      py::arg("pos"), py::arg("style") = nullptr,
       "Plots vertical error bar. The label_id should be the same as the "
       "label_id of the associated line or bar plot.");
   m.def(
       "plot_error_bars_h",
       [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
-         const py::buffer& neg, const py::buffer& pos) {
-        // TODO implement ValueGetter for 4 components
-        throw std::runtime_error("not implemented");
+         const py::buffer& err, const ItemStyle* style) {
+        BufferGroup<3> buffers({&xs, &ys, &err});
+        apply_style(style);
+        plot_error_bars_values(label_id, buffers, true);
+      },
+      py::arg("label_id"), py::arg("xs"), py::arg("ys"), py::arg("err"),
+      py::arg("style") = nullptr,
+      "Plots horizontal error bars of symmetric size #err. The label_id should "
+      "be the same as the label_id of the associated line or bar plot.");
+  m.def(
+      "plot_error_bars_h",
+      [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
+         const py::buffer& neg, const py::buffer& pos, const ItemStyle* style) {
+        BufferGroup<4> buffers({&xs, &ys, &neg, &pos});
+        apply_style(style);
+        plot_error_bars_values(label_id, buffers, true);
       },
       py::arg("label_id"), py::arg("xs"), py::arg("ys"), py::arg("neg"),
-      py::arg("pos"),
+      py::arg("pos"), py::arg("style") = nullptr,
       "Plots horizontal error bars. The label_id should be the same as the "
       "label_id of the associated line or bar plot.");
 
   m.def(
       "plot_stems",
-      [](const char* label_id, const py::buffer& values) {
-        // TODO no getter (G) version
-        throw std::runtime_error("not implemented");
+      [](const char* label_id, const py::buffer& values, double y_ref,
+         const ItemStyle* style) {
+        BufferGroup<1> buffers({&values});
+        py::gil_scoped_release release;
+        apply_style(style);
+        buffers.visit([&](const auto& ptrs, int stride) {
+          ImPlot::PlotStems(label_id, ptrs[0], buffers.count(), y_ref, 1.0,
+                            0.0, 0, stride);
+        });
       },
-      py::arg("label_id"), py::arg("values"), "Plots vertical stems.");
+      py::arg("label_id"), py::arg("values"), py::arg("y_ref") = 0.0,
+      py::arg("style") = nullptr,
+      "Plots vertical stems.");
   m.def(
       "plot_stems",
-      [](const char* label_id, const py::buffer& xs, const py::buffer& ys) {
-        // TODO no getter (G) version
-        throw std::runtime_error("not implemented");
+      [](const char* label_id, const py::buffer& xs, const py::buffer& ys,
+         double y_ref, const ItemStyle* style) {
+        BufferGroup<2> buffers({&xs, &ys});
+        py::gil_scoped_release release;
+        apply_style(style);
+        buffers.visit([&](const auto& ptrs, int stride) {
+          ImPlot::PlotStems(label_id, ptrs[0], ptrs[1], buffers.count(), y_ref,
+                            0, stride);
+        });
       },
-      py::arg("label_id"), py::arg("xs"), py::arg("ys"),
+      py::arg("label_id"), py::arg("xs"), py::arg("ys"), py::arg("y_ref") = 0.0,
+      py::arg("style") = nullptr,
       "Plots vertical stems.");
 
   m.def(
       "plot_pie_chart",
-      [](const std::vector<const char*>& label_ids, const py::buffer& values,
+      [](const std::vector<std::string>& label_ids, const py::buffer& values,
          double x, double y, double radius, bool normalize,
          const char* label_fmt, double angle0) {
-        // TODO ImPlot::PlotPieChart has no getter overload
-        throw std::runtime_error("not implemented");
+        BufferGroup<1> buffers({&values});
+        if (label_ids.size() != static_cast<size_t>(buffers.count())) {
+          throw std::invalid_argument(
+              "Number of labels and values does not match!");
+        }
+        std::vector<const char*> labels;
+        labels.reserve(label_ids.size());
+        for (const auto& label_id : label_ids) {
+          labels.push_back(label_id.c_str());
+        }
+        py::gil_scoped_release release;
+        // PlotPieChart has no stride parameter
+        buffers.visit(
+            [&](const auto& ptrs, int) {
+              ImPlot::PlotPieChart(labels.data(), ptrs[0], buffers.count(), x,
+                                   y, radius, normalize, label_fmt, angle0);
+            },
+            true);
       },
       py::arg("label_ids"), py::arg("values"), py::arg("x"), py::arg("y"),
       py::arg("radius"), py::arg("normalize") = false,
@@ -694,14 +1469,13 @@ void py_init_module_implot(py::module& m) {
       "value will be normalized. Center and radius are in plot units. "
       "#label_fmt can be set to NULL for no labels.");
 
-  m.def(
-      "plot_heatmap",
-      []() {
-        // TODO
-        throw std::runtime_error("not implemented");
-      },
-      "Plots a 2D heatmap chart. Values are expected to be in row-major order. "
-      "#label_fmt can be set to NULL for no labels.");
+  m.def("plot_heatmap", &plot_heatmap_values, py::arg("label_id"),
+        py::arg("values"), py::arg("scale_min"), py::arg("scale_max"),
+        py::arg("label_fmt") = "%.1f",
+        py::arg("bounds_min") = ImPlotPoint(0, 0),
+        py::arg("bounds_max") = ImPlotPoint(1, 1),
+        "Plots a 2D heatmap chart. Row 0 of #values is drawn at the top. "
+        "#label_fmt can be set to NULL for no labels.");
 
   m.def(
       "plot_digital",
@@ -758,7 +1532,47 @@ void py_init_module_implot(py::module& m) {
         "Set the Y axis range limits of the next plot. Call right before "
         "BeginPlot(). If ImGuiCond_Always is used, the Y axis limits will be "
         "locked.");
-  // TODO m.def("link_next_plot_limits", &ImPlot::LinkNextPlotLimits);
+  m.def(
+      "link_next_plot_limits",
+      [](const char* x, const char* y, const char* y2, const char* y3) {
+        ImPlotRange* ranges[] = {linked_range(x), linked_range(y),
+                                 linked_range(y2), linked_range(y3)};
+        double* limits[8] = {};
+        for (int axis = 0; axis < 4; ++axis) {
+          if (ranges[axis] != nullptr) {
+            limits[2 * axis] = &ranges[axis]->Min;
+            limits[2 * axis + 1] = &ranges[axis]->Max;
+          }
+        }
+        ImPlot::LinkNextPlotLimits(limits[0], limits[1], limits[2], limits[3],
+                                   limits[4], limits[5], limits[6],
+                                   limits[7]);
+      },
+      py::arg("x") = nullptr, py::arg("y") = nullptr,
+      py::arg("y2") = nullptr, py::arg("y3") = nullptr,
+      "Links the axes of the next plot to named groups, all axes of a group "
+      "share their limits. Panning or zooming one updates the plots after it "
+      "in the same frame, the ones before it in the next. Call right before "
+      "BeginPlot().");
+  m.def(
+      "set_linked_limits",
+      [](const std::string& group, double min, double max) {
+        *linked_range(group.c_str()) = ImPlotRange(min, max);
+      },
+      py::arg("group"), py::arg("min"), py::arg("max"),
+      "Sets the limits of a group of linked axes.");
+  m.def(
+      "get_linked_limits",
+      [](const std::string& group) {
+        const auto it = linkedLimits.find(group);
+        if (it == linkedLimits.end()) {
+          throw py::key_error("Unknown linked axis group '" + group + "'!");
+        }
+        return std::make_pair(it->second.Min, it->second.Max);
+      },
+      py::arg("group"),
+      "Returns the limits of a group of linked axes. Raises KeyError if no "
+      "axis was linked to the group and its limits were never set.");
   m.def("fit_next_plot_axes", &ImPlot::FitNextPlotAxes, py::arg("x") = true,
         py::arg("y") = true, py::arg("y2") = true, py::arg("y3") = true,
         "Fits the next plot axes to all plotted data if they are unlocked "
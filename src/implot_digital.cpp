@@ -0,0 +1,359 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <implot.h>
+#include <implot_internal.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include "plot_kernels.hpp"
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// Row layout of a bits buffer. 1D buffers of integers hold one row per value,
+// 2D buffers of bytes (e.g. np.packbits(axis=1) output) one row per index.
+static kernels::PackedRows packed_rows(const py::buffer_info& info,
+                                       const std::string& bitorder) {
+  if (bitorder != "little" && bitorder != "big") {
+    throw std::invalid_argument("bitorder must be 'little' or 'big'!");
+  }
+  const auto type = ValueGetter::resolve_value_type(info);
+  if (type == ValueType::Float16 || type == ValueType::Float ||
+      type == ValueType::Double) {
+    throw std::runtime_error("Bits must be integers!");
+  }
+  kernels::PackedRows rows{};
+  rows.data = static_cast<const unsigned char*>(info.ptr);
+  rows.bigBitOrder = bitorder == "big";
+  if (info.ndim == 1) {
+    rows.stride = info.strides.at(0);
+    rows.rowBytes = static_cast<int>(info.itemsize);
+    rows.reversedBytes = ValueGetter::is_byte_swapped(info);
+  } else if (info.ndim == 2 && info.itemsize == 1 &&
+             info.strides.at(1) == 1 && info.shape.at(1) > 0) {
+    rows.stride = info.strides.at(0);
+    rows.rowBytes = static_cast<int>(info.shape.at(1));
+    rows.reversedBytes = false;
+  } else {
+    throw std::runtime_error(
+        "Bits must be 1D integers or 2D bytes with contiguous rows!");
+  }
+  return rows;
+}
+
+// Transitions of one channel: its state at row base and the later rows at
+// which the state flips.
+struct ChannelRuns {
+  std::ptrdiff_t base = 0;
+  bool initial = false;
+  std::vector<std::ptrdiff_t> flips;
+
+  // State at row (not before base) and the index of the first flip after it.
+  [[nodiscard]] std::pair<bool, size_t> state_at(std::ptrdiff_t row) const {
+    const auto k = static_cast<size_t>(
+        std::upper_bound(this->flips.begin(), this->flips.end(), row) -
+        this->flips.begin());
+    return {this->initial != ((k & 1) != 0), k};
+  }
+};
+
+// Extracts the transitions of the first channels of rows [first, last).
+static void extract_runs(const kernels::PackedRows& rows, std::ptrdiff_t first,
+                         std::ptrdiff_t last, int channels,
+                         std::vector<ChannelRuns>& out) {
+  out.resize(channels);
+  for (int c = 0; c < channels; ++c) {
+    out[c].base = first;
+    out[c].initial = first < last && rows.bit(first, c);
+    out[c].flips.clear();
+  }
+  kernels::for_each_transition(rows, first, last,
+                               [&](std::ptrdiff_t row, int channel) {
+                                 if (channel < channels) {
+                                   out[channel].flips.push_back(row);
+                                 }
+                               });
+}
+
+// Rows [first, last) covering the x limits of the plot plus one on each side,
+// all of them while the plot is being fit. xs must be sorted.
+template <typename Xs>
+static std::pair<std::ptrdiff_t, std::ptrdiff_t>
+visible_rows(const Xs& xs, std::ptrdiff_t count) {
+  if (ImPlot::FitThisFrame()) {
+    return {0, count};
+  }
+  const auto limits = ImPlot::GetPlotLimits().X;
+  auto first = kernels::lower_bound(xs, 0, count, limits.Min);
+  auto last = kernels::upper_bound(xs, first, count, limits.Max);
+  first = std::max<std::ptrdiff_t>(first - 1, 0);
+  last = std::min<std::ptrdiff_t>(last + 1, count);
+  return {first, last};
+}
+
+// Plots the rows [first, last) of a channel like ImPlot's PlotDigital(): a
+// bar of the bit height while high, of the line weight while low, stacked
+// above the digital items plotted before. Runs narrower than a pixel are
+// merged into one high bar, so the cost is bounded by the plot width rather
+// than by the number of transitions. x_extent is only used when fitting.
+template <typename Xs>
+static void plot_digital_runs(const char* label_id, const Xs& xs,
+                              std::ptrdiff_t first, std::ptrdiff_t last,
+                              const ChannelRuns& runs,
+                              const ImPlotRange& x_extent) {
+  if (!ImPlot::BeginItem(label_id, ImPlotCol_Fill)) {
+    return;
+  }
+  ImPlotContext& gp = *GImPlot;
+  if (gp.FitThisFrame) {
+    // Digital plots do not respond to y, only fit x
+    ImPlot::FitPoint(ImPlotPoint(x_extent.Min, NAN));
+    ImPlot::FitPoint(ImPlotPoint(x_extent.Max, NAN));
+  }
+  const ImPlotNextItemData& s = ImPlot::GetItemData();
+  if (last - first > 1 && s.RenderFill) {
+    ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+    const ImU32 col = ImGui::GetColorU32(s.Colors[ImPlotCol_Fill]);
+    const int y_axis = gp.CurrentPlot->CurrentYAxis;
+    const ImRect& pixels = gp.PixelRange[y_axis];
+    // ImPlot keeps 20 pixels free at the bottom for the mouse position
+    const float bottom = pixels.Min.y - gp.DigitalPlotOffset - 20;
+    const float low = bottom - static_cast<int>(s.LineWeight);
+    const float high = low - static_cast<int>(gp.Style.DigitalBitHeight);
+    const float left = ImMin(pixels.Min.x, pixels.Max.x);
+    const float right = ImMax(pixels.Min.x, pixels.Max.x);
+    const bool visible =
+        (bottom >= gp.BB_Plot.Min.y && bottom < gp.BB_Plot.Max.y) ||
+        (high >= gp.BB_Plot.Min.y && high < gp.BB_Plot.Max.y);
+    auto to_pixel = [&](std::ptrdiff_t row) {
+      return ImPlot::PlotToPixels(xs[row], 0.0, y_axis).x;
+    };
+    auto bar = [&](float x0, float x1, float top) {
+      x0 = ImClamp(x0, left, right);
+      x1 = ImClamp(x1, left, right);
+      if (visible && x0 != x1) {
+        draw_list.AddRectFilled(ImVec2(ImMin(x0, x1), bottom),
+                                ImVec2(ImMax(x0, x1), top), col);
+      }
+    };
+
+    const auto& flips = runs.flips;
+    const std::ptrdiff_t end = last - 1;
+    // The last run ends at the last row, flips from there on do not matter
+    const auto k_end = static_cast<size_t>(
+        std::lower_bound(flips.begin(), flips.end(), end) - flips.begin());
+    auto [state, k] = runs.state_at(first);
+    std::ptrdiff_t row = first;
+    float x0 = to_pixel(first);
+    // Direction of increasing x, axes may be inverted
+    const float dir = to_pixel(end) >= x0 ? 1.0f : -1.0f;
+    bool merging = false;
+    float merge_begin = 0.0f;
+    while (row < end) {
+      const std::ptrdiff_t next = k < k_end ? flips[k] : end;
+      const float x1 = to_pixel(next);
+      if ((x1 - x0) * dir >= 1.0f || next == end) {
+        if (merging) {
+          bar(merge_begin, x0, high);
+          merging = false;
+        }
+        bar(x0, x1, state ? high : low);
+        row = next;
+        x0 = x1;
+        state = !state;
+        ++k;
+        continue;
+      }
+      // Skip all flips before the next pixel, they become one high bar
+      if (!merging) {
+        merging = true;
+        merge_begin = x0;
+      }
+      const double boundary =
+          ImPlot::PixelsToPlot(ImVec2(x0 + dir, 0.0f), y_axis).x;
+      const auto k_next = static_cast<size_t>(
+          std::partition_point(
+              flips.begin() + k + 1, flips.begin() + k_end,
+              [&](std::ptrdiff_t flip) { return xs[flip] < boundary; }) -
+          flips.begin());
+      state = state != (((k_next - k) & 1) != 0);
+      row = flips[k_next - 1];
+      k = k_next;
+      x0 = to_pixel(row);
+    }
+    if (merging) {
+      bar(merge_begin, x0, high);
+    }
+    gp.DigitalPlotItemCnt++;
+    gp.DigitalPlotOffset +=
+        static_cast<int>(gp.Style.DigitalBitHeight + gp.Style.DigitalBitGap);
+  }
+  ImPlot::EndItem();
+}
+
+static void check_labels(const std::vector<std::string>& labels,
+                         int channels) {
+  if (labels.size() > static_cast<size_t>(channels)) {
+    throw std::invalid_argument("More labels than channels!");
+  }
+}
+
+// Bits of many digital channels with timestamps. The transitions of every
+// channel are extracted once when the data is set, plots then only look at
+// the transitions inside the x limits. Plots and touch() keep the GIL, so no
+// other thread extracts the transitions again while they are read.
+class DigitalSeries {
+public:
+  DigitalSeries(const py::buffer& xs, const py::buffer& bits,
+                const std::string& bitorder)
+      : xs(std::make_unique<ValueGetter>(xs)), bits(bits.request()),
+        rows(packed_rows(this->bits, bitorder)) {
+    if (this->bits.shape.at(0) != this->xs->size()) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+    // Not shared with other threads yet
+    py::gil_scoped_release release;
+    extract();
+  }
+
+  // Extracts the transitions again after the data was modified in place.
+  void touch() { extract(); }
+
+  void plot(const std::vector<std::string>& labels) {
+    check_labels(labels, this->rows.channels());
+    this->xs->visit_y([&](const auto& values) {
+      const auto [first, last] = visible_rows(values, this->xs->size());
+      for (size_t c = 0; c < labels.size(); ++c) {
+        plot_digital_runs(labels[c].c_str(), values, first, last,
+                          this->runs[c], this->xExtent);
+      }
+    });
+  }
+
+  [[nodiscard]] int get_channels() const { return this->rows.channels(); }
+  [[nodiscard]] int get_size() const { return this->xs->size(); }
+
+private:
+  void extract() {
+    const auto count = this->xs->size();
+    this->xs->visit_y([&](const auto& values) {
+      if (!kernels::is_sorted(values, count)) {
+        throw std::invalid_argument("xs must be sorted ascending!");
+      }
+      const auto [lo, hi] = kernels::min_max(values, 0, count);
+      this->xExtent = ImPlotRange(lo, hi);
+    });
+    extract_runs(this->rows, 0, count, this->rows.channels(), this->runs);
+  }
+
+  std::unique_ptr<ValueGetter> xs;
+  py::buffer_info bits;
+  kernels::PackedRows rows;
+  std::vector<ChannelRuns> runs;
+  ImPlotRange xExtent;
+};
+
+void py_init_module_implot_digital(py::module& m) {
+  py::class_<DigitalSeries>(
+      m, "DigitalSeries",
+      "Packed bits of many digital channels (e.g. a logic capture) with "
+      "sorted timestamps. The transitions of all channels are extracted once, "
+      "plots then only draw the runs inside the x limits.")
+      .def(py::init<const py::buffer&, const py::buffer&,
+                    const std::string&>(),
+           py::arg("xs"), py::arg("bits"), py::arg("bitorder") = "little",
+           "bits is a 1D array of integers (bit c of a value is channel c) or "
+           "a 2D array of bytes, one row per sample. Use bitorder='big' for "
+           "np.packbits() output with its default bit order.")
+      .def("touch", &DigitalSeries::touch,
+           "Extracts the transitions again after the data was modified in "
+           "place.")
+      .def_property_readonly("channels", &DigitalSeries::get_channels)
+      .def("__len__", &DigitalSeries::get_size);
+
+  m.def(
+      "plot_digital_packed",
+      [](const std::vector<std::string>& labels, DigitalSeries& series) {
+        series.plot(labels);
+      },
+      py::arg("labels"), py::arg("series"),
+      "Plots the first len(labels) channels of a digital series, like "
+      "plot_digital() per channel. Runs narrower than a pixel are drawn as "
+      "one high bar.");
+  m.def(
+      "plot_digital_packed",
+      [](const std::vector<std::string>& labels, const py::buffer& xs,
+         const py::buffer& bits, const std::string& bitorder) {
+        const ValueGetter value_getter(xs);
+        const auto info = bits.request();
+        const auto rows = packed_rows(info, bitorder);
+        if (info.shape.at(0) != value_getter.size()) {
+          throw std::runtime_error("Incompatible buffer dimension!");
+        }
+        check_labels(labels, rows.channels());
+        py::gil_scoped_release release;
+        thread_local std::vector<ChannelRuns> runs;
+        value_getter.visit_y([&](const auto& values) {
+          const auto count = value_getter.size();
+          const auto [first, last] = visible_rows(values, count);
+          extract_runs(rows, first, last, static_cast<int>(labels.size()),
+                       runs);
+          ImPlotRange x_extent;
+          if (ImPlot::FitThisFrame()) {
+            const auto [lo, hi] = kernels::min_max(values, 0, count);
+            x_extent = ImPlotRange(lo, hi);
+          }
+          for (size_t c = 0; c < labels.size(); ++c) {
+            plot_digital_runs(labels[c].c_str(), values, first, last, runs[c],
+                              x_extent);
+          }
+        });
+      },
+      py::arg("labels"), py::arg("xs"), py::arg("bits"),
+      py::arg("bitorder") = "little",
+      "Plots the first len(labels) channels of packed bits, like "
+      "plot_digital() per channel. bits is a 1D array of integers (bit c of "
+      "a value is channel c) or a 2D array of bytes, one row per sample. Use "
+      "bitorder='big' for np.packbits() output with its default bit order. "
+      "xs must be sorted. Only the visible rows are scanned, for repeated "
+      "plots of long captures use a DigitalSeries.");
+}
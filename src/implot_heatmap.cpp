@@ -0,0 +1,248 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <algorithm>
+#include <glad/glad.h>
+#include <imgui.h>
+#include <implot.h>
+#include <mutex>
+#include <pybind11/pybind11.h>
+#include <utility>
+#include <vector>
+
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// Textures of destroyed heatmaps with the ImGui context they were created in.
+// Heatmaps may be collected on any thread, or after the window is gone, so
+// the textures are deleted by the next heatmap plotted in their context.
+static std::mutex orphanedMutex;
+static std::vector<std::pair<ImGuiContext*, GLuint>> orphanedTextures;
+
+// Deletes the orphaned textures of the current context. Those of other
+// contexts are kept for a heatmap plotted in their own context.
+static void delete_orphaned_textures() {
+  std::lock_guard<std::mutex> lock(orphanedMutex);
+  const auto* context = ImGui::GetCurrentContext();
+  const auto deleted = std::remove_if(
+      orphanedTextures.begin(), orphanedTextures.end(),
+      [&](const std::pair<ImGuiContext*, GLuint>& orphan) {
+        if (orphan.first != context) {
+          return false;
+        }
+        glDeleteTextures(1, &orphan.second);
+        return true;
+      });
+  orphanedTextures.erase(deleted, orphanedTextures.end());
+}
+
+// Heatmap drawn as a single textured quad instead of one rect per cell. The
+// values are colormapped on the CPU through a lookup table into an RGBA
+// texture, and only the rows updated since the last frame are uploaded.
+class HeatmapTexture {
+public:
+  HeatmapTexture(int rows, int cols, double scale_min, double scale_max)
+      : rows(rows), cols(cols) {
+    if (rows <= 0 || cols <= 0) {
+      throw std::invalid_argument("Rows and columns must be positive!");
+    }
+    set_scale(scale_min, scale_max);
+    this->pixels.resize(static_cast<size_t>(rows) * cols, 0);
+  }
+  ~HeatmapTexture() {
+    if (this->texture != 0) {
+      std::lock_guard<std::mutex> lock(orphanedMutex);
+      orphanedTextures.emplace_back(this->context, this->texture);
+    }
+  }
+  HeatmapTexture(const HeatmapTexture&) = delete;
+  HeatmapTexture& operator=(const HeatmapTexture&) = delete;
+
+  // Takes effect for the rows updated afterwards.
+  void set_scale(double scale_min, double scale_max) {
+    if (!(scale_min < scale_max)) {
+      throw std::invalid_argument("scale_min must be less than scale_max!");
+    }
+    this->scaleMin = scale_min;
+    this->scaleMax = scale_max;
+  }
+
+  // Colormaps the 2D buffer into rows [first_row, first_row + values.rows)
+  // using the current colormap. Keeps the GIL, plot() reads the pixels.
+  void update(const py::buffer& values, int first_row) {
+    const auto info = values.request();
+    if (info.ndim != 2 || info.shape[1] != this->cols || first_row < 0 ||
+        info.shape[0] > this->rows - first_row) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+    const auto type = ValueGetter::resolve_value_type(info);
+    const auto count = static_cast<int>(info.shape[0]);
+    if (count == 0) {
+      return;
+    }
+    build_lut();
+
+    const double lut_scale = (lut_size - 1) / (this->scaleMax - this->scaleMin);
+    const bool swapped = ValueGetter::is_byte_swapped(info);
+    for (int row = 0; row < count; ++row) {
+      const auto* in =
+          static_cast<const char*>(info.ptr) + row * info.strides[0];
+      ImU32* out = this->pixels.data() +
+                   static_cast<size_t>(first_row + row) * this->cols;
+      visit_values(in, info.strides[1], type, swapped, [&](const auto& values) {
+        for (int col = 0; col < this->cols; ++col) {
+          const double index = (values[col] - this->scaleMin) * lut_scale;
+          if (index >= 0.0 && index <= lut_size - 1) {
+            out[col] = this->lut[static_cast<int>(index + 0.5)];
+          } else if (index < 0.0) {
+            out[col] = this->lut[0];
+          } else if (index > 0.0) {
+            out[col] = this->lut[lut_size - 1];
+          } else {
+            // NaN stays transparent
+            out[col] = 0;
+          }
+        }
+      });
+    }
+    this->dirtyFirst = std::min(this->dirtyFirst, first_row);
+    this->dirtyLast = std::max(this->dirtyLast, first_row + count);
+  }
+
+  // Uploads the dirty rows and plots the texture. Must be called between
+  // BeginPlot() and EndPlot().
+  void plot(const char* label_id, const ImPlotPoint& bounds_min,
+            const ImPlotPoint& bounds_max) {
+    delete_orphaned_textures();
+    if (this->context != ImGui::GetCurrentContext()) {
+      // Created for an earlier window, the texture went away with it
+      this->texture = 0;
+      this->context = ImGui::GetCurrentContext();
+    }
+    GLint last_texture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &last_texture);
+    if (this->texture == 0) {
+      GLint max_size;
+      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+      if (this->rows > max_size || this->cols > max_size) {
+        throw std::runtime_error("Heatmap exceeds the maximum texture size!");
+      }
+      glGenTextures(1, &this->texture);
+      glBindTexture(GL_TEXTURE_2D, this->texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->cols, this->rows, 0,
+                   GL_RGBA, GL_UNSIGNED_BYTE, this->pixels.data());
+    } else if (this->dirtyFirst < this->dirtyLast) {
+      glBindTexture(GL_TEXTURE_2D, this->texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, this->dirtyFirst, this->cols,
+                      this->dirtyLast - this->dirtyFirst, GL_RGBA,
+                      GL_UNSIGNED_BYTE,
+                      this->pixels.data() +
+                          static_cast<size_t>(this->dirtyFirst) * this->cols);
+    }
+    glBindTexture(GL_TEXTURE_2D, last_texture);
+    this->dirtyFirst = this->rows;
+    this->dirtyLast = 0;
+
+    ImPlot::PlotImage(label_id,
+                      reinterpret_cast<ImTextureID>(
+                          static_cast<intptr_t>(this->texture)),
+                      bounds_min, bounds_max);
+  }
+
+  [[nodiscard]] int get_rows() const { return rows; }
+  [[nodiscard]] int get_cols() const { return cols; }
+
+private:
+  void build_lut() {
+    for (int i = 0; i < lut_size; ++i) {
+      this->lut[i] = ImGui::ColorConvertFloat4ToU32(
+          ImPlot::LerpColormap(static_cast<float>(i) / (lut_size - 1)));
+    }
+  }
+
+  static const constexpr int lut_size = 256;
+
+  const int rows;
+  const int cols;
+  double scaleMin = 0.0;
+  double scaleMax = 1.0;
+  ImU32 lut[lut_size] = {};
+  std::vector<ImU32> pixels;
+  GLuint texture = 0;
+  // Context the texture belongs to
+  ImGuiContext* context = nullptr;
+  // Rows [dirtyFirst, dirtyLast) have to be uploaded
+  int dirtyFirst = 0;
+  int dirtyLast = 0;
+};
+
+void py_init_module_implot_heatmap(py::module& m) {
+  py::class_<HeatmapTexture>(
+      m, "HeatmapTexture",
+      "Heatmap for large or live matrices that is colormapped into a texture "
+      "and drawn as a single image. Only updated rows are uploaded.")
+      .def(py::init<int, int, double, double>(), py::arg("rows"),
+           py::arg("cols"), py::arg("scale_min"), py::arg("scale_max"))
+      .def("update", &HeatmapTexture::update, py::arg("values"),
+           py::arg("first_row") = 0,
+           "Colormaps the rows of the 2D buffer #values into the rows "
+           "starting at #first_row, using the current colormap.")
+      .def("set_scale", &HeatmapTexture::set_scale, py::arg("scale_min"),
+           py::arg("scale_max"), "Applies to the rows updated afterwards.")
+      .def_property_readonly("rows", &HeatmapTexture::get_rows)
+      .def_property_readonly("cols", &HeatmapTexture::get_cols);
+
+  m.def(
+      "plot_heatmap",
+      [](const char* label_id, HeatmapTexture& heatmap,
+         const ImPlotPoint& bounds_min, const ImPlotPoint& bounds_max) {
+        heatmap.plot(label_id, bounds_min, bounds_max);
+      },
+      py::arg("label_id"), py::arg("heatmap"),
+      py::arg("bounds_min") = ImPlotPoint(0, 0),
+      py::arg("bounds_max") = ImPlotPoint(1, 1),
+      "Plots a heatmap texture as a single image. Row 0 is drawn at the top.");
+}
@@ -0,0 +1,311 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "file_mapping.hpp"
+#include "value_getter.hpp"
+#include "worker_pool.hpp"
+
+namespace py = pybind11;
+
+// Column of doubles produced by a loader, exposed as a 1D buffer.
+struct Column {
+  std::vector<double> values;
+
+  [[nodiscard]] py::buffer_info buffer() {
+    // Buffers may not point to nullptr, even when empty
+    static double empty = 0.0;
+    double* data = this->values.empty() ? &empty : this->values.data();
+    return py::buffer_info(data, sizeof(double), "d", 1,
+                           {static_cast<py::ssize_t>(this->values.size())},
+                           {static_cast<py::ssize_t>(sizeof(double))});
+  }
+};
+
+static int pool_threads(int threads) {
+  if (threads < 0) {
+    throw std::invalid_argument("threads must not be negative!");
+  }
+  return threads > 0
+             ? threads
+             : static_cast<int>(
+                   std::max(1u, std::thread::hardware_concurrency()));
+}
+
+static void trim(const char*& begin, const char*& end) {
+  while (begin < end && (*begin == ' ' || *begin == '\t')) {
+    ++begin;
+  }
+  while (end > begin && (end[-1] == ' ' || end[-1] == '\t')) {
+    --end;
+  }
+}
+
+// Parses a CSV field, NaN if it is empty or not a number.
+static double parse_field(const char* begin, const char* end) {
+  trim(begin, end);
+  if (begin < end && *begin == '+') {
+    ++begin;
+  }
+  if (begin == end) {
+    return NAN;
+  }
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  double value;
+  const auto [ptr, ec] = std::from_chars(begin, end, value);
+  return ec == std::errc() && ptr == end ? value : NAN;
+#else
+  // strtod() needs a terminated string, numbers are short
+  char field[64];
+  const auto length = static_cast<size_t>(end - begin);
+  if (length >= sizeof(field)) {
+    return NAN;
+  }
+  std::memcpy(field, begin, length);
+  field[length] = '\0';
+  char* stop = nullptr;
+  const double value = std::strtod(field, &stop);
+  return stop == field + length ? value : NAN;
+#endif
+}
+
+// Finds the next non-empty line of [begin, end), without the line break, and
+// moves begin past it. Returns false at the end.
+static bool next_line(const char*& begin, const char* end, const char*& line,
+                      const char*& line_end) {
+  while (begin < end) {
+    const auto* newline = static_cast<const char*>(
+        std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+    const char* stop = newline != nullptr ? newline : end;
+    line = begin;
+    line_end = stop > begin && stop[-1] == '\r' ? stop - 1 : stop;
+    begin = newline != nullptr ? newline + 1 : end;
+    if (line_end > line) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <typename Fn>
+static void for_each_line(const char* begin, const char* end, Fn&& fn) {
+  const char* line;
+  const char* line_end;
+  while (next_line(begin, end, line, line_end)) {
+    fn(line, line_end);
+  }
+}
+
+// Calls fn(column, begin, end) for the fields of a line.
+template <typename Fn>
+static void for_each_field(const char* begin, const char* end, char delimiter,
+                           Fn&& fn) {
+  for (size_t column = 0;; ++column) {
+    const auto* next = static_cast<const char*>(
+        std::memchr(begin, delimiter, static_cast<size_t>(end - begin)));
+    if (next == nullptr) {
+      fn(column, begin, end);
+      return;
+    }
+    fn(column, begin, next);
+    begin = next + 1;
+  }
+}
+
+// Loads the numeric columns of a CSV file. The mapped file is split into
+// chunks at line boundaries, the pool counts the rows of every chunk and then
+// parses each chunk straight into its rows of the columns.
+static py::dict load_csv(const std::string& path, char delimiter,
+                         bool header, int threads) {
+  const FileMapping file(path, AccessPattern::Sequential);
+  const char* begin = file.data();
+  const char* end = begin + file.size();
+  // The first line names or at least counts the columns
+  std::vector<std::string> names;
+  const char* body = begin;
+  const char* line;
+  const char* line_end;
+  if (begin != nullptr && next_line(body, end, line, line_end)) {
+    for_each_field(line, line_end, delimiter,
+                   [&](size_t, const char* field, const char* field_end) {
+                     trim(field, field_end);
+                     if (field_end - field >= 2 && *field == '"' &&
+                         field_end[-1] == '"') {
+                       ++field;
+                       --field_end;
+                     }
+                     names.emplace_back(field, field_end);
+                   });
+    begin = header ? body : begin;
+  }
+  const size_t columns = names.size();
+
+  std::vector<std::vector<double>> values(columns);
+  {
+    py::gil_scoped_release release;
+    WorkerPool pool(pool_threads(threads));
+    const auto bytes = static_cast<size_t>(end - begin);
+    const int chunks = static_cast<int>(std::clamp<size_t>(
+        bytes >> 20, 1, static_cast<size_t>(4 * pool.size())));
+    // bounds[k] is the start of the line chunk k starts with
+    std::vector<const char*> bounds(chunks + 1, end);
+    bounds[0] = begin;
+    for (int k = 1; k < chunks; ++k) {
+      const char* split = std::max(begin + bytes * k / chunks, bounds[k - 1]);
+      const auto* newline = static_cast<const char*>(
+          std::memchr(split, '\n', static_cast<size_t>(end - split)));
+      bounds[k] = newline != nullptr ? newline + 1 : end;
+    }
+    std::vector<size_t> rows(chunks + 1, 0);
+    pool.run(chunks, [&](int k) {
+      for_each_line(bounds[k], bounds[k + 1],
+                    [&](const char*, const char*) { ++rows[k + 1]; });
+    });
+    for (int k = 0; k < chunks; ++k) {
+      rows[k + 1] += rows[k];
+    }
+    for (auto& column : values) {
+      column.resize(rows[chunks]);
+    }
+    pool.run(chunks, [&](int k) {
+      size_t row = rows[k];
+      for_each_line(bounds[k], bounds[k + 1], [&](const char* line,
+                                                  const char* line_end) {
+        size_t parsed = 0;
+        for_each_field(line, line_end, delimiter,
+                       [&](size_t column, const char* field,
+                           const char* field_end) {
+                         if (column < columns) {
+                           values[column][row] = parse_field(field, field_end);
+                           parsed = column + 1;
+                         }
+                       });
+        for (; parsed < columns; ++parsed) {
+          values[parsed][row] = NAN;
+        }
+        ++row;
+      });
+    });
+  }
+
+  py::dict result;
+  for (size_t c = 0; c < columns; ++c) {
+    auto column = py::cast(Column{std::move(values[c])});
+    if (header) {
+      result[py::str(names[c])] = column;
+    } else {
+      result[py::int_(static_cast<int>(c))] = column;
+    }
+  }
+  return result;
+}
+
+// Converts every column of a 1D or 2D buffer to doubles, in row chunks on a
+// worker pool.
+static py::list load_columns(const py::buffer& buffer, int threads) {
+  const auto info = buffer.request();
+  if (info.ndim != 1 && info.ndim != 2) {
+    throw std::runtime_error("Incompatible buffer dimension!");
+  }
+  const auto type = ValueGetter::resolve_value_type(info);
+  const auto rows = static_cast<size_t>(info.shape.at(0));
+  const auto columns =
+      static_cast<size_t>(info.ndim == 2 ? info.shape.at(1) : 1);
+  std::vector<std::vector<double>> values(columns);
+  {
+    py::gil_scoped_release release;
+    WorkerPool pool(pool_threads(threads));
+    for (auto& column : values) {
+      column.resize(rows);
+    }
+    // Chunks of at least 64k rows
+    const int chunks = static_cast<int>(std::clamp<size_t>(
+        rows >> 16, 1, static_cast<size_t>(4 * pool.size())));
+    pool.run(chunks, [&](int k) {
+      const auto first = static_cast<py::ssize_t>(rows * k / chunks);
+      const auto last = static_cast<py::ssize_t>(rows * (k + 1) / chunks);
+      for (size_t c = 0; c < columns; ++c) {
+        double* out = values[c].data();
+        visit_column(info, type, static_cast<py::ssize_t>(c),
+                     [&](const auto& column) {
+                       for (auto i = first; i < last; ++i) {
+                         out[i] = column[i];
+                       }
+                     });
+      }
+    });
+  }
+  py::list result;
+  for (auto& column : values) {
+    result.append(py::cast(Column{std::move(column)}));
+  }
+  return result;
+}
+
+void py_init_module_implot_loader(py::module& m) {
+  py::class_<Column>(m, "Column", py::buffer_protocol(),
+                     "Column of doubles loaded by load_csv() or "
+                     "load_columns(), usable wherever plots take buffers.")
+      .def_buffer(&Column::buffer)
+      .def("__len__", [](const Column& c) { return c.values.size(); });
+
+  m.def("load_csv", &load_csv, py::arg("path"), py::arg("delimiter") = ',',
+        py::arg("header") = true, py::arg("threads") = 0,
+        "Loads the numeric columns of a CSV file on #threads threads (0 uses "
+        "all cores). Returns a dict from the column names of the header line "
+        "(or the column indices without one) to Columns. Fields that are not "
+        "numbers become NaN.");
+  m.def("load_columns", &load_columns, py::arg("values"),
+        py::arg("threads") = 0,
+        "Converts the columns of a 1D or 2D buffer, e.g. a MappedFile of raw "
+        "samples, to a list of Columns on #threads threads (0 uses all "
+        "cores).");
+}
@@ -0,0 +1,228 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <pybind11/pybind11.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "file_mapping.hpp"
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// One channel of a MappedFile as a 1D buffer. Keeps the mapping alive.
+struct MappedChannel {
+  std::shared_ptr<const FileMapping> mapping;
+  const char* data;
+  py::ssize_t size;
+  py::ssize_t stride;
+  py::ssize_t itemsize;
+  std::string format;
+
+  [[nodiscard]] py::buffer_info buffer() const {
+    return py::buffer_info(const_cast<char*>(this->data), this->itemsize,
+                           this->format, 1, {this->size}, {this->stride},
+                           true);
+  }
+};
+
+// Raw binary file of samples, e.g. an acquisition log, exposed as a buffer
+// without reading it. Pages are only loaded once a plot touches them, plots
+// of sorted or y-only data only touch the visible range (see VisibleRange).
+// After an optional header, the file holds samples of a fixed number of
+// channels, either interleaved (sample major) or one channel after another.
+// A trailing partial sample is ignored.
+class MappedFile {
+public:
+  MappedFile(const std::string& path, const std::string& format, int channels,
+             int64_t offset, bool interleaved, AccessPattern access)
+      : channels(channels), interleaved(interleaved), offset(offset),
+        format(format) {
+    if (channels <= 0 || offset < 0) {
+      throw std::invalid_argument(
+          "Channels must be positive and offset not negative!");
+    }
+    // The struct module knows the item sizes of all format strings
+    this->itemsize = py::module::import("struct")
+                         .attr("calcsize")(format)
+                         .cast<py::ssize_t>();
+    ValueGetter::resolve_value_type(
+        py::buffer_info(nullptr, this->itemsize, format, 0));
+    this->mapping = std::make_shared<const FileMapping>(path, access);
+    const auto bytes = static_cast<int64_t>(this->mapping->size());
+    this->size = bytes > offset ? (bytes - offset) / row_bytes() : 0;
+  }
+
+  // 1D buffer of the samples if there is one channel, (samples, channels)
+  // otherwise.
+  [[nodiscard]] py::buffer_info buffer() const {
+    if (this->channels == 1) {
+      return channel(0).buffer();
+    }
+    const auto sample_stride = this->interleaved ? row_bytes() : itemsize;
+    const auto channel_stride =
+        this->interleaved ? itemsize : this->size * itemsize;
+    return py::buffer_info(
+        const_cast<char*>(base()), this->itemsize, this->format, 2,
+        {static_cast<py::ssize_t>(this->size),
+         static_cast<py::ssize_t>(this->channels)},
+        {static_cast<py::ssize_t>(sample_stride),
+         static_cast<py::ssize_t>(channel_stride)},
+        true);
+  }
+
+  [[nodiscard]] MappedChannel channel(int c) const {
+    if (c < 0 || c >= this->channels) {
+      throw std::out_of_range("Illegal channel index.");
+    }
+    const auto first = this->interleaved ? c * this->itemsize
+                                         : c * this->size * this->itemsize;
+    const auto stride = this->interleaved ? row_bytes() : this->itemsize;
+    return MappedChannel{this->mapping,
+                         this->size > 0 ? base() + first : base(),
+                         static_cast<py::ssize_t>(this->size),
+                         static_cast<py::ssize_t>(stride),
+                         static_cast<py::ssize_t>(this->itemsize),
+                         this->format};
+  }
+
+  // Sets the access pattern of the samples [first, last) of all channels.
+  void advise(AccessPattern access, int64_t first, int64_t last) const {
+    for_each_range(first, last, [&](size_t offset, size_t length) {
+      this->mapping->advise(access, offset, length);
+    });
+  }
+
+  // Starts reading the samples [first, last) of all channels in the
+  // background, e.g. ahead of scrolling.
+  void prefetch(int64_t first, int64_t last) const {
+    for_each_range(first, last, [&](size_t offset, size_t length) {
+      this->mapping->prefetch(offset, length);
+    });
+  }
+
+  [[nodiscard]] int64_t get_size() const { return this->size; }
+  [[nodiscard]] int get_channels() const { return this->channels; }
+
+private:
+  [[nodiscard]] int64_t row_bytes() const {
+    return this->channels * this->itemsize;
+  }
+
+  [[nodiscard]] const char* base() const {
+    // Buffers may not point to nullptr, even when empty
+    static const char empty = 0;
+    return this->size > 0 ? this->mapping->data() + this->offset : &empty;
+  }
+
+  // Calls fn(offset, length) for the file bytes of the samples [first, last),
+  // last < 0 meaning the end.
+  template <typename Fn>
+  void for_each_range(int64_t first, int64_t last, Fn&& fn) const {
+    last = last < 0 ? this->size : last;
+    if (first < 0 || first > last || last > this->size) {
+      throw std::out_of_range("Illegal sample range.");
+    }
+    if (this->interleaved) {
+      fn(static_cast<size_t>(this->offset + first * row_bytes()),
+         static_cast<size_t>((last - first) * row_bytes()));
+      return;
+    }
+    for (int c = 0; c < this->channels; ++c) {
+      const auto start = this->offset + (c * this->size + first) * itemsize;
+      fn(static_cast<size_t>(start),
+         static_cast<size_t>((last - first) * itemsize));
+    }
+  }
+
+  const int channels;
+  const bool interleaved;
+  const int64_t offset;
+  const std::string format;
+  int64_t itemsize = 0;
+  int64_t size = 0;
+  std::shared_ptr<const FileMapping> mapping;
+};
+
+void py_init_module_implot_mapped(py::module& m) {
+  py::enum_<AccessPattern>(m, "Access",
+                           "Expected access pattern of a memory mapped file.")
+      .value("Normal", AccessPattern::Normal, "no particular order")
+      .value("Sequential", AccessPattern::Sequential,
+             "front to back, pages are read ahead and dropped early")
+      .value("Random", AccessPattern::Random, "no read ahead");
+
+  py::class_<MappedChannel>(m, "MappedChannel", py::buffer_protocol(),
+                            "Read-only 1D buffer of one channel of a "
+                            "MappedFile.")
+      .def_buffer(&MappedChannel::buffer)
+      .def("__len__", [](const MappedChannel& c) { return c.size; });
+
+  py::class_<MappedFile>(
+      m, "MappedFile", py::buffer_protocol(),
+      "Raw binary file of samples, memory mapped instead of read. Pass it "
+      "(one channel) or channel(c) wherever plots take buffers, only the "
+      "pages of the visible range are loaded. Use SeriesPyramid for files of "
+      "more than 2^31 - 1 samples.")
+      .def(py::init<const std::string&, const std::string&, int, int64_t,
+                    bool, AccessPattern>(),
+           py::arg("path"), py::arg("format"), py::arg("channels") = 1,
+           py::arg("offset") = 0, py::arg("interleaved") = true,
+           py::arg("access") = AccessPattern::Normal,
+           "#format is a struct module format (e.g. '<h' or 'f'), #offset "
+           "the size of the file header in bytes. Samples of all channels are "
+           "either interleaved or stored one channel after another.")
+      .def_buffer(&MappedFile::buffer)
+      .def("channel", &MappedFile::channel, py::arg("c"),
+           "Returns channel #c as a 1D buffer.")
+      .def("advise", &MappedFile::advise, py::arg("access"),
+           py::arg("first") = 0, py::arg("last") = -1,
+           "Sets the access pattern of the samples [first, last), -1 is the "
+           "end. Ignored on Windows, which only takes it when opening.")
+      .def("prefetch", &MappedFile::prefetch, py::arg("first") = 0,
+           py::arg("last") = -1,
+           "Starts loading the samples [first, last) in the background.")
+      .def_property_readonly("channels", &MappedFile::get_channels)
+      .def("__len__", &MappedFile::get_size);
+}
@@ -0,0 +1,371 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <implot.h>
+#include <implot_internal.h>
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include "plot_fit.hpp"
+#include "plot_kernels.hpp"
+#include "plot_style.hpp"
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// Min, max and mean of the non-NaN values of a range.
+struct Summary {
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double sum = 0.0;
+  int64_t count = 0;
+
+  void add(double y) {
+    if (!std::isnan(y)) {
+      this->min = y < this->min ? y : this->min;
+      this->max = y > this->max ? y : this->max;
+      this->sum += y;
+      ++this->count;
+    }
+  }
+  void add(const Summary& other) {
+    this->min = other.min < this->min ? other.min : this->min;
+    this->max = other.max > this->max ? other.max : this->max;
+    this->sum += other.sum;
+    this->count += other.count;
+  }
+  [[nodiscard]] double mean() const {
+    return this->count > 0 ? this->sum / static_cast<double>(this->count)
+                           : NAN;
+  }
+};
+
+// Series too long to scan every frame, e.g. a recording of hundreds of
+// millions of samples in a memory mapped file. Summaries of blocks of 64
+// samples, of 8 such blocks, of 8 of those and so on are built once. Any
+// index range is then summarized from at most a few summaries per level plus
+// the raw samples at its ends, so a plot costs O(pixels * levels) at any zoom
+// level. Indices are 64 bit, the series may exceed ImPlot's int counts.
+// Plots and touch() keep the GIL, so no other thread rebuilds the summaries
+// while they are read.
+class SeriesPyramid {
+public:
+  SeriesPyramid(const py::buffer& ys, double x0, double dx)
+      : hasX(false), infoY(ys.request()), x0(x0), dx(dx) {
+    if (!(dx > 0.0) || !std::isfinite(x0)) {
+      throw std::invalid_argument("dx must be positive and x0 finite!");
+    }
+    init();
+  }
+  SeriesPyramid(const py::buffer& xs, const py::buffer& ys)
+      : hasX(true), infoX(xs.request()), infoY(ys.request()) {
+    if (this->infoX.ndim != 1 ||
+        this->infoX.shape.at(0) != this->infoY.shape.at(0)) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+    this->typeX = ValueGetter::resolve_value_type(this->infoX);
+    init();
+  }
+
+  // Builds the summaries again after the data was modified in place.
+  void touch() { build(); }
+
+  // Plots the visible range as a line through the minimum and maximum of
+  // every pixel column, or through the column means if #mean. Ranges of no
+  // more than two samples per pixel are plotted as they are.
+  void plot(const char* label_id, bool mean) {
+    CachedFit fit(label_id,
+                  [&]() -> const ImPlotLimits& { return this->extents; });
+    column_bounds();
+    thread_local std::vector<std::ptrdiff_t> indices;
+    thread_local std::vector<double> points;
+    indices.clear();
+    points.clear();
+    const auto first = this->bounds.front();
+    const auto last = this->bounds.back();
+    const auto columns = static_cast<std::ptrdiff_t>(this->bounds.size()) - 1;
+    visit_y([&](const auto& ys) {
+      // One extra sample on each side so lines leave the plot area correctly
+      auto emit = [&](std::ptrdiff_t idx, double y) {
+        indices.push_back(idx);
+        points.push_back(0.0);
+        points.push_back(y);
+      };
+      if (first > 0) {
+        emit(first - 1, ys[first - 1]);
+      }
+      if (last - first <= 2 * columns) {
+        for (auto i = first; i < last; ++i) {
+          emit(i, ys[i]);
+        }
+      } else {
+        for (std::ptrdiff_t c = 0; c < columns; ++c) {
+          const auto a = this->bounds[c];
+          const auto b = this->bounds[c + 1];
+          const Summary s = summarize(ys, a, b);
+          if (s.count == 0) {
+            continue;
+          }
+          if (mean) {
+            emit(a + (b - a) / 2, s.mean());
+            continue;
+          }
+          // Enter each column at the extreme closer to the previous point
+          const bool rising =
+              points.empty() || std::abs(points.back() - s.min) <=
+                                    std::abs(points.back() - s.max);
+          emit(a, rising ? s.min : s.max);
+          emit(b - 1, rising ? s.max : s.min);
+        }
+      }
+      if (last < size()) {
+        emit(last, ys[last]);
+      }
+    });
+    visit_x([&](const auto& xs) {
+      for (size_t i = 0; i < indices.size(); ++i) {
+        points[2 * i] = xs[indices[i]];
+      }
+    });
+    ImPlot::PlotLine(label_id, points.data(), points.data() + 1,
+                     static_cast<int>(indices.size()), 0,
+                     static_cast<int>(2 * sizeof(double)));
+  }
+
+  // Returns (min, max, mean) of the non-NaN values [first, last).
+  [[nodiscard]] std::tuple<double, double, double>
+  summary(int64_t first, int64_t last) const {
+    if (first < 0 || first > last || last > size()) {
+      throw std::out_of_range("Illegal index range.");
+    }
+    Summary s;
+    visit_y([&](const auto& ys) { s = summarize(ys, first, last); });
+    return {s.min, s.max, s.mean()};
+  }
+
+  [[nodiscard]] int64_t get_size() const { return size(); }
+  [[nodiscard]] int get_levels() const {
+    return static_cast<int>(this->levels.size());
+  }
+
+private:
+  static constexpr std::ptrdiff_t block = 64;
+  static constexpr std::ptrdiff_t fanout = 8;
+
+  [[nodiscard]] std::ptrdiff_t size() const { return this->infoY.shape.at(0); }
+
+  void init() {
+    if (this->infoY.ndim != 1) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+    this->typeY = ValueGetter::resolve_value_type(this->infoY);
+    // Not shared with other threads yet
+    py::gil_scoped_release release;
+    build();
+  }
+
+  template <typename Fn> void visit_x(Fn&& fn) const {
+    if (hasX) {
+      visit_column(this->infoX, this->typeX, 0, std::forward<Fn>(fn));
+    } else {
+      fn(kernels::make_func_array([x0 = this->x0, dx = this->dx](
+                                      std::ptrdiff_t idx) {
+        return x0 + dx * static_cast<double>(idx);
+      }));
+    }
+  }
+
+  template <typename Fn> void visit_y(Fn&& fn) const {
+    visit_column(this->infoY, this->typeY, 0, std::forward<Fn>(fn));
+  }
+
+  void build() {
+    const auto n = size();
+    this->levels.clear();
+    visit_y([&](const auto& ys) {
+      auto& level = this->levels.emplace_back((n + block - 1) / block);
+      for (std::ptrdiff_t k = 0; k < static_cast<std::ptrdiff_t>(level.size());
+           ++k) {
+        const auto last = std::min(n, (k + 1) * block);
+        for (auto i = k * block; i < last; ++i) {
+          level[k].add(ys[i]);
+        }
+      }
+    });
+    while (this->levels.back().size() > 1) {
+      const auto& below = this->levels.back();
+      std::vector<Summary> level((below.size() + fanout - 1) / fanout);
+      for (size_t k = 0; k < below.size(); ++k) {
+        level[k / fanout].add(below[k]);
+      }
+      this->levels.push_back(std::move(level));
+    }
+    Summary all;
+    if (!this->levels.back().empty()) {
+      all = this->levels.back()[0];
+    }
+    this->extents.Y = ImPlotRange(all.min, all.max);
+    visit_x([&](const auto& xs) {
+      if (hasX && !kernels::is_sorted(xs, n)) {
+        throw std::invalid_argument("xs must be sorted ascending!");
+      }
+      this->extents.X = n > 0 ? ImPlotRange(xs[0], xs[n - 1])
+                              : ImPlotRange(this->x0, this->x0);
+    });
+  }
+
+  // Summarizes ys[first, last) from the raw samples up to the next block
+  // boundaries and the largest aligned summaries in between.
+  template <typename Ys>
+  Summary summarize(const Ys& ys, std::ptrdiff_t first,
+                    std::ptrdiff_t last) const {
+    Summary s;
+    for (; first < last && first % block != 0; ++first) {
+      s.add(ys[first]);
+    }
+    for (; last > first && last % block != 0; --last) {
+      s.add(ys[last - 1]);
+    }
+    auto i = first / block;
+    auto j = last / block;
+    for (const auto& level : this->levels) {
+      for (; i < j && i % fanout != 0; ++i) {
+        s.add(level[i]);
+      }
+      for (; j > i && j % fanout != 0; --j) {
+        s.add(level[j - 1]);
+      }
+      if (i == j) {
+        break;
+      }
+      i /= fanout;
+      j /= fanout;
+    }
+    return s;
+  }
+
+  // Splits the visible samples into pixel columns, bounds[c] is the first
+  // sample of column c. While fitting, the whole series is split evenly.
+  void column_bounds() {
+    const auto n = size();
+    const int columns =
+        std::max(1, static_cast<int>(ImPlot::GetPlotSize().x));
+    thread_local std::vector<double> edges;
+    edges.resize(columns + 1);
+    if (ImPlot::FitThisFrame()) {
+      const auto& x = this->extents.X;
+      for (int c = 0; c <= columns; ++c) {
+        edges[c] = x.Min + (x.Max - x.Min) * c / columns;
+      }
+      edges[columns] = std::nextafter(x.Max, INFINITY);
+    } else {
+      // Going through pixel space handles log scale and inverted axes
+      const float left = ImPlot::GetPlotPos().x;
+      for (int c = 0; c <= columns; ++c) {
+        edges[c] = ImPlot::PixelsToPlot(left + c, 0.0f).x;
+      }
+      if (edges.front() > edges.back()) {
+        std::reverse(edges.begin(), edges.end());
+      }
+    }
+    this->bounds.resize(columns + 1);
+    visit_x([&](const auto& xs) {
+      std::ptrdiff_t idx = 0;
+      for (int c = 0; c <= columns; ++c) {
+        idx = kernels::lower_bound(xs, idx, n, edges[c]);
+        this->bounds[c] = idx;
+      }
+    });
+  }
+
+  const bool hasX;
+  const py::buffer_info infoX;
+  const py::buffer_info infoY;
+  ValueType typeX = ValueType::Double;
+  ValueType typeY = ValueType::Double;
+  // x values if there is no xs buffer
+  const double x0 = 0.0;
+  const double dx = 1.0;
+  // levels[k][i] summarizes the samples [i * 64 * 8^k, (i + 1) * 64 * 8^k)
+  std::vector<std::vector<Summary>> levels;
+  ImPlotLimits extents;
+  // See column_bounds()
+  std::vector<std::ptrdiff_t> bounds;
+};
+
+void py_init_module_implot_pyramid(py::module& m) {
+  py::class_<SeriesPyramid>(
+      m, "SeriesPyramid",
+      "Long series (e.g. a memory mapped recording) with min/max/mean "
+      "summaries at decreasing resolutions, built once. Plots cost O(pixels) "
+      "at any zoom level and the series may hold more than 2^31 samples.")
+      .def(py::init<const py::buffer&, double, double>(), py::arg("ys"),
+           py::arg("x0") = 0.0, py::arg("dx") = 1.0,
+           "Samples at x = x0 + index * dx.")
+      .def(py::init<const py::buffer&, const py::buffer&>(), py::arg("xs"),
+           py::arg("ys"), "Samples with sorted x values.")
+      .def("touch", &SeriesPyramid::touch,
+           "Builds the summaries again after the data was modified in place.")
+      .def("summary", &SeriesPyramid::summary, py::arg("first"),
+           py::arg("last"),
+           "Returns (min, max, mean) of the non-NaN samples [first, last).")
+      .def_property_readonly("levels", &SeriesPyramid::get_levels,
+                             "Number of summary levels")
+      .def("__len__", &SeriesPyramid::get_size);
+
+  m.def(
+      "plot_line",
+      [](const char* label_id, SeriesPyramid& series, bool mean,
+         const ItemStyle* style) {
+        apply_style(style);
+        series.plot(label_id, mean);
+      },
+      py::arg("label_id"), py::arg("series"), py::arg("mean") = false,
+      py::arg("style") = nullptr,
+      "Plots the min/max envelope of a series pyramid per pixel column, or "
+      "the column means if #mean.");
+}
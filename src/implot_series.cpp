@@ -0,0 +1,555 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <implot.h>
+#include <pybind11/pybind11.h>
+
+#include <atomic>
+#include <cstdint>
+
+#include "plot_fit.hpp"
+#include "plot_style.hpp"
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// Checks that ys has the shape (n,) or (n, channels) matching xs of shape (n,).
+static void check_batch(const py::buffer_info& infoX,
+                        const py::buffer_info& infoY, int channels) {
+  const bool y_ok = (infoY.ndim == 1 && channels == 1) ||
+                    (infoY.ndim == 2 && infoY.shape.at(1) == channels);
+  if (infoX.ndim != 1 || !y_ok || infoX.shape.at(0) != infoY.shape.at(0)) {
+    throw std::runtime_error("Incompatible buffer dimension!");
+  }
+}
+
+// Fixed capacity ring buffer for scrolling plots. Every sample has one x value
+// and a y value per channel. The data is plotted in place using ImPlot's
+// offset argument, pushing never moves existing samples. Reads and writes
+// keep the GIL, acquisition threads push from Python while the render thread
+// plots.
+class RingSeries {
+public:
+  RingSeries(int capacity, int channels)
+      : capacity(capacity), channels(channels) {
+    if (capacity <= 0 || channels <= 0) {
+      throw std::invalid_argument("Capacity and channels must be positive!");
+    }
+    this->xs.resize(capacity);
+    this->ys.resize(static_cast<size_t>(capacity) * channels);
+    this->columnExtents.resize(channels + 1, empty_extent());
+    this->columnStale.resize(channels + 1, false);
+  }
+
+  void push(double x, double y) {
+    if (this->channels != 1) {
+      throw std::invalid_argument(error_channels);
+    }
+    store(this->xs.data(), 0, this->head, x);
+    store(this->ys.data(), 1, this->head, y);
+    advance(1);
+  }
+
+  // Pushes one sample with a value per channel.
+  void push(double x, const py::buffer& y) {
+    const auto info = y.request();
+    if (info.ndim != 1 || info.shape.at(0) != this->channels) {
+      throw std::runtime_error(error_channels);
+    }
+    const auto value_type = ValueGetter::resolve_value_type(info);
+    store(this->xs.data(), 0, this->head, x);
+    visit_column(info, value_type, 0, [&](const auto& values) {
+      for (int c = 0; c < this->channels; ++c) {
+        store(this->ys.data() + channel_base(c), c + 1, this->head, values[c]);
+      }
+    });
+    advance(1);
+  }
+
+  // Pushes a batch of samples, ys has the shape (n,) or (n, channels). If the
+  // batch is larger than the capacity only the newest samples are kept.
+  void extend(const py::buffer& bufX, const py::buffer& bufY) {
+    const auto infoX = bufX.request();
+    const auto infoY = bufY.request();
+    check_batch(infoX, infoY, this->channels);
+    const auto count = infoX.shape.at(0);
+    const auto first = std::max<py::ssize_t>(count - this->capacity, 0);
+    const auto typeX = ValueGetter::resolve_value_type(infoX);
+    const auto typeY = ValueGetter::resolve_value_type(infoY);
+
+    visit_column(infoX, typeX, 0, [&](const auto& values) {
+      write(this->xs.data(), 0, values, first, count);
+    });
+    for (int c = 0; c < this->channels; ++c) {
+      visit_column(infoY, typeY, c, [&](const auto& values) {
+        write(this->ys.data() + channel_base(c), c + 1, values, first, count);
+      });
+    }
+    advance(static_cast<int>(count - first));
+  }
+
+  // Appends count interleaved samples, each is x followed by the value of
+  // every channel. Only the newest #capacity samples are kept.
+  void append(const double* samples, int count) {
+    const int stride = this->channels + 1;
+    const int first = std::max(count - this->capacity, 0);
+    for (int column = 0; column <= this->channels; ++column) {
+      double* ring = column == 0 ? this->xs.data()
+                                 : this->ys.data() + channel_base(column - 1);
+      const kernels::StridedArray<double> values{
+          reinterpret_cast<const char*>(samples + column),
+          static_cast<std::ptrdiff_t>(stride * sizeof(double))};
+      write(ring, column, values, first, count);
+    }
+    advance(count - first);
+  }
+
+  void clear() {
+    this->head = 0;
+    this->size = 0;
+    std::fill(this->columnExtents.begin(), this->columnExtents.end(),
+              empty_extent());
+    std::fill(this->columnStale.begin(), this->columnStale.end(), false);
+    this->lastStoredX = -std::numeric_limits<double>::infinity();
+    this->xAscending = true;
+  }
+
+  // Sets the x limits of the next plot to the newest history x units.
+  void set_next_plot_limits_x(double history, ImGuiCond cond) const {
+    const double x_max = this->size > 0 ? last_x() : 0.0;
+    ImPlot::SetNextPlotLimitsX(x_max - history, x_max, cond);
+  }
+
+  // Calls fn(xs, ys, count, offset) with the arguments for ImPlot's typed API
+  // to plot the item label_id. If the plot is being fit, ImPlot gets the
+  // cached extents instead of scanning the samples.
+  template <typename Fn>
+  void visit(const char* label_id, int channel, Fn&& fn) {
+    if (channel < 0 || channel >= this->channels) {
+      throw std::out_of_range("Illegal channel index.");
+    }
+    CachedFit fit(label_id, [&]() { return extents(channel); });
+    // Once the buffer is full, the oldest sample is at head
+    const int offset = this->size == this->capacity ? this->head : 0;
+    fn(this->xs.data(), this->ys.data() + channel_base(channel), this->size,
+       offset);
+  }
+
+  [[nodiscard]] double last_x() const {
+    if (this->size == 0) {
+      throw std::out_of_range("RingSeries is empty.");
+    }
+    return this->xs[(this->head + this->capacity - 1) % this->capacity];
+  }
+
+  [[nodiscard]] int get_size() const { return this->size; }
+  [[nodiscard]] int get_capacity() const { return this->capacity; }
+  [[nodiscard]] int get_channels() const { return this->channels; }
+
+private:
+  static const constexpr char* error_channels =
+      "Sample does not match the number of channels!";
+
+  [[nodiscard]] size_t channel_base(int channel) const {
+    return static_cast<size_t>(channel) * this->capacity;
+  }
+
+  static ImPlotRange empty_extent() {
+    return ImPlotRange(std::numeric_limits<double>::infinity(),
+                       -std::numeric_limits<double>::infinity());
+  }
+
+  // Extents of x and a channel. Grown on every store, a column is only
+  // rescanned if one of its samples holding a minimum or maximum was
+  // overwritten. Ascending x values span from the oldest to the newest
+  // sample.
+  ImPlotLimits extents(int channel) {
+    ImPlotLimits limits;
+    if (this->xAscending && this->size > 0) {
+      const int oldest = this->size == this->capacity ? this->head : 0;
+      limits.X = ImPlotRange(this->xs[oldest], last_x());
+    } else {
+      limits.X = column_extent(0);
+    }
+    limits.Y = column_extent(channel + 1);
+    return limits;
+  }
+
+  const ImPlotRange& column_extent(int column) {
+    if (this->columnStale[column]) {
+      const double* ring = column == 0
+                               ? this->xs.data()
+                               : this->ys.data() + channel_base(column - 1);
+      const auto [lo, hi] = kernels::min_max(
+          kernels::PackedArray<double>{ring}, 0, this->size);
+      this->columnExtents[column] = ImPlotRange(lo, hi);
+      this->columnStale[column] = false;
+    }
+    return this->columnExtents[column];
+  }
+
+  // Writes a value to a ring position of a column (0 is x, 1 + c channel c).
+  void store(double* ring, int column, int pos, double value) {
+    auto& extent = this->columnExtents[column];
+    if (column == 0 && this->xAscending) {
+      // Scrolling plots overwrite the minimum with every sample, the extent
+      // is only needed once x goes back (or is NaN)
+      if (!(value >= this->lastStoredX)) {
+        this->xAscending = false;
+        this->columnStale[0] = true;
+      }
+      this->lastStoredX = value;
+    } else if (pos < this->size &&
+               (ring[pos] == extent.Min || ring[pos] == extent.Max)) {
+      // Positions below size hold a sample, see advance()
+      this->columnStale[column] = true;
+    }
+    ring[pos] = value;
+    extent.Min = value < extent.Min ? value : extent.Min;
+    extent.Max = value > extent.Max ? value : extent.Max;
+  }
+
+  // Copies values[first, last) to the ring positions starting at head.
+  template <typename Values>
+  void write(double* ring, int column, const Values& values, py::ssize_t first,
+             py::ssize_t last) {
+    auto pos = this->head;
+    for (auto i = first; i < last; ++i) {
+      store(ring, column, pos, values[i]);
+      if (++pos == this->capacity) {
+        pos = 0;
+      }
+    }
+  }
+
+  void advance(int count) {
+    this->head = (this->head + count) % this->capacity;
+    this->size = std::min(this->size + count, this->capacity);
+  }
+
+  const int capacity;
+  const int channels;
+  std::vector<double> xs;
+  // Channel major, each channel is a ring of its own
+  std::vector<double> ys;
+  // Position of the next sample
+  int head = 0;
+  int size = 0;
+  // x and every channel
+  std::vector<ImPlotRange> columnExtents;
+  std::vector<bool> columnStale;
+  // Whether every x value stored since clear() was at least the one before
+  double lastStoredX = -std::numeric_limits<double>::infinity();
+  bool xAscending = true;
+};
+
+// Lock-free single producer, single consumer queue of samples. An acquisition
+// thread pushes while the render thread drains into a RingSeries, neither
+// ever waits for the other. Samples are stored interleaved, x followed by the
+// value of every channel. If the queue is full, new samples are dropped.
+class Channel {
+public:
+  // Producer interface for native extensions, handed out as a PyCapsule.
+  struct CApi {
+    void* channel;
+    // Pushes count interleaved samples, returns the number accepted.
+    size_t (*push)(void* channel, const double* samples, size_t count);
+  };
+
+  Channel(int capacity, int channels)
+      : capacity(capacity), channels(channels), stride(channels + 1) {
+    if (capacity <= 0 || channels <= 0) {
+      throw std::invalid_argument("Capacity and channels must be positive!");
+    }
+    this->samples.resize(static_cast<size_t>(capacity) * this->stride);
+    this->cApi = CApi{this, &Channel::c_push};
+  }
+
+  bool push(double x, double y) {
+    if (this->channels != 1) {
+      throw std::invalid_argument(error_channels);
+    }
+    const size_t accepted = writable(1);
+    if (accepted == 1) {
+      double* sample = slot(this->head.load(std::memory_order_relaxed));
+      sample[0] = x;
+      sample[1] = y;
+    }
+    publish(accepted, 1);
+    return accepted == 1;
+  }
+
+  // Pushes one sample with a value per channel.
+  bool push(double x, const py::buffer& y) {
+    const auto info = y.request();
+    if (info.ndim != 1 || info.shape.at(0) != this->channels) {
+      throw std::runtime_error(error_channels);
+    }
+    const auto value_type = ValueGetter::resolve_value_type(info);
+    const size_t accepted = writable(1);
+    if (accepted == 1) {
+      double* sample = slot(this->head.load(std::memory_order_relaxed));
+      sample[0] = x;
+      visit_column(info, value_type, 0, [&](const auto& values) {
+        for (int c = 0; c < this->channels; ++c) {
+          sample[c + 1] = values[c];
+        }
+      });
+    }
+    publish(accepted, 1);
+    return accepted == 1;
+  }
+
+  // Pushes a batch of samples, ys has the shape (n,) or (n, channels). The
+  // copy runs without the GIL. Returns the number of samples accepted.
+  size_t extend(const py::buffer& bufX, const py::buffer& bufY) {
+    const auto infoX = bufX.request();
+    const auto infoY = bufY.request();
+    check_batch(infoX, infoY, this->channels);
+    const auto typeX = ValueGetter::resolve_value_type(infoX);
+    const auto typeY = ValueGetter::resolve_value_type(infoY);
+    const auto count = static_cast<size_t>(infoX.shape.at(0));
+
+    py::gil_scoped_release release;
+    const size_t accepted = writable(count);
+    const auto head = this->head.load(std::memory_order_relaxed);
+    for (int column = 0; column <= this->channels; ++column) {
+      const auto& info = column == 0 ? infoX : infoY;
+      visit_column(info, column == 0 ? typeX : typeY,
+                   column == 0 ? 0 : column - 1, [&](const auto& values) {
+                     for (size_t i = 0; i < accepted; ++i) {
+                       slot(head + i)[column] = values[i];
+                     }
+                   });
+    }
+    publish(accepted, count);
+    return accepted;
+  }
+
+  // Moves all queued samples into series, returns how many were moved.
+  // Consumer side, call from the render thread. Keeps the GIL, as series may
+  // be written from Python as well.
+  size_t drain_into(RingSeries& series) {
+    if (series.get_channels() != this->channels) {
+      throw std::invalid_argument(error_channels);
+    }
+    const auto tail = this->tail.load(std::memory_order_relaxed);
+    const auto head = this->head.load(std::memory_order_acquire);
+    const auto count = static_cast<size_t>(head - tail);
+    // The queued samples wrap around the end of the storage at most once
+    const auto first = static_cast<size_t>(tail % this->capacity);
+    const auto contiguous = std::min(count, this->capacity - first);
+    series.append(slot(tail), static_cast<int>(contiguous));
+    series.append(this->samples.data(), static_cast<int>(count - contiguous));
+    this->tail.store(tail + count, std::memory_order_release);
+    return count;
+  }
+
+  // Number of queued samples, only a snapshot if the producer is running.
+  [[nodiscard]] size_t get_size() const {
+    return static_cast<size_t>(this->head.load(std::memory_order_acquire) -
+                               this->tail.load(std::memory_order_acquire));
+  }
+  [[nodiscard]] uint64_t get_dropped() const {
+    return this->dropped.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] int get_capacity() const {
+    return static_cast<int>(this->capacity);
+  }
+  [[nodiscard]] int get_channels() const { return this->channels; }
+
+  py::capsule c_api() { return py::capsule(&this->cApi, capsule_name); }
+
+  static constexpr const char* capsule_name = "mahi_gui.implot.Channel.CApi";
+
+private:
+  static const constexpr char* error_channels =
+      "Sample does not match the number of channels!";
+
+  static size_t c_push(void* channel, const double* samples, size_t count) {
+    auto& self = *static_cast<Channel*>(channel);
+    const size_t accepted = self.writable(count);
+    const auto head = self.head.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < accepted; ++i) {
+      std::copy_n(samples + i * self.stride, self.stride, self.slot(head + i));
+    }
+    self.publish(accepted, count);
+    return accepted;
+  }
+
+  [[nodiscard]] double* slot(uint64_t pos) {
+    return this->samples.data() + (pos % this->capacity) * this->stride;
+  }
+
+  // Producer side: how many of count samples fit into the free slots.
+  [[nodiscard]] size_t writable(size_t count) const {
+    const auto used = this->head.load(std::memory_order_relaxed) -
+                      this->tail.load(std::memory_order_acquire);
+    return std::min(count, static_cast<size_t>(this->capacity - used));
+  }
+
+  // Producer side: hands the written samples to the consumer.
+  void publish(size_t accepted, size_t count) {
+    this->head.fetch_add(accepted, std::memory_order_release);
+    if (accepted < count) {
+      this->dropped.fetch_add(count - accepted, std::memory_order_relaxed);
+    }
+  }
+
+  const size_t capacity;
+  const int channels;
+  const size_t stride;
+  std::vector<double> samples;
+  CApi cApi;
+  // Both only ever grow, the slot is the position modulo capacity. Written by
+  // one side each, kept on separate cache lines.
+  alignas(64) std::atomic<uint64_t> head{0};
+  alignas(64) std::atomic<uint64_t> tail{0};
+  alignas(64) std::atomic<uint64_t> dropped{0};
+};
+
+void py_init_module_implot_series(py::module& m) {
+  py::class_<RingSeries>(
+      m, "RingSeries",
+      "Fixed capacity ring buffer for scrolling real-time plots. Each sample "
+      "has one x value and a y value per channel. Plotting does not copy or "
+      "move the data.")
+      .def(py::init<int, int>(), py::arg("capacity"), py::arg("channels") = 1)
+      .def("push", py::overload_cast<double, double>(&RingSeries::push),
+           py::arg("x"), py::arg("y"),
+           "Appends a sample, overwriting the oldest one if full.")
+      .def("push",
+           py::overload_cast<double, const py::buffer&>(&RingSeries::push),
+           py::arg("x"), py::arg("y"),
+           "Appends a sample with one value per channel, overwriting the "
+           "oldest one if full.")
+      .def("extend", &RingSeries::extend, py::arg("xs"), py::arg("ys"),
+           "Appends a batch of samples. ys has the shape (n,) or (n, "
+           "channels). Only the newest #capacity samples are kept.")
+      .def("clear", &RingSeries::clear, "Removes all samples.")
+      .def("set_next_plot_limits_x", &RingSeries::set_next_plot_limits_x,
+           py::arg("history"), py::arg("cond") = ImGuiCond_Always,
+           "Sets the x axis limits of the next plot to show the newest "
+           "#history x units. Call right before BeginPlot().")
+      .def_property_readonly("last_x", &RingSeries::last_x,
+                             "x value of the newest sample")
+      .def_property_readonly("capacity", &RingSeries::get_capacity)
+      .def_property_readonly("channels", &RingSeries::get_channels)
+      .def("__len__", &RingSeries::get_size);
+
+  py::class_<Channel>(
+      m, "Channel",
+      "Lock-free queue from one acquisition thread to the render thread. "
+      "The producer pushes samples without waiting for rendering, the render "
+      "loop drains them into a RingSeries at the start of each frame. Use one "
+      "producer thread and one consumer thread per channel.")
+      .def(py::init<int, int>(), py::arg("capacity"), py::arg("channels") = 1)
+      .def("push", py::overload_cast<double, double>(&Channel::push),
+           py::arg("x"), py::arg("y"),
+           "Queues a sample. Returns False and drops it if the queue is full.")
+      .def("push", py::overload_cast<double, const py::buffer&>(&Channel::push),
+           py::arg("x"), py::arg("y"),
+           "Queues a sample with one value per channel. Returns False and "
+           "drops it if the queue is full.")
+      .def("extend", &Channel::extend, py::arg("xs"), py::arg("ys"),
+           "Queues a batch of samples, ys has the shape (n,) or (n, "
+           "channels). The copy does not hold the GIL. Returns the number of "
+           "samples queued, the rest is dropped.")
+      .def("drain_into", &Channel::drain_into, py::arg("series"),
+           "Moves all queued samples into a RingSeries. Returns the number of "
+           "samples moved.")
+      .def_property_readonly("dropped", &Channel::get_dropped,
+                             "Number of samples dropped because the queue was "
+                             "full")
+      .def_property_readonly(
+          "c_api", &Channel::c_api,
+          "PyCapsule named 'mahi_gui.implot.Channel.CApi' for producers in "
+          "native extensions. It points to struct { void* channel; size_t "
+          "(*push)(void* channel, const double* samples, size_t count); }, "
+          "samples are interleaved as x followed by one value per channel. "
+          "Keep the Channel alive while using it.")
+      .def_property_readonly("capacity", &Channel::get_capacity)
+      .def_property_readonly("channels", &Channel::get_channels)
+      .def("__len__", &Channel::get_size);
+
+  m.def(
+      "plot_line",
+      [](const char* label_id, RingSeries& series, int channel,
+         const ItemStyle* style) {
+        series.visit(label_id, channel,
+                     [&](const double* xs, const double* ys, int count,
+                         int offset) {
+                       apply_style(style);
+                       ImPlot::PlotLine(label_id, xs, ys, count, offset);
+                     });
+      },
+      py::arg("label_id"), py::arg("series"), py::arg("channel") = 0,
+      py::arg("style") = nullptr,
+      "Plots a channel of a ring series as a standard 2D line plot.");
+  m.def(
+      "plot_scatter",
+      [](const char* label_id, RingSeries& series, int channel,
+         const ItemStyle* style) {
+        series.visit(label_id, channel,
+                     [&](const double* xs, const double* ys, int count,
+                         int offset) {
+                       apply_style(style);
+                       ImPlot::PlotScatter(label_id, xs, ys, count, offset);
+                     });
+      },
+      py::arg("label_id"), py::arg("series"), py::arg("channel") = 0,
+      py::arg("style") = nullptr,
+      "Plots a channel of a ring series as a standard 2D scatter plot.");
+  m.def(
+      "plot_stairs",
+      [](const char* label_id, RingSeries& series, int channel,
+         const ItemStyle* style) {
+        series.visit(label_id, channel,
+                     [&](const double* xs, const double* ys, int count,
+                         int offset) {
+                       apply_style(style);
+                       ImPlot::PlotStairs(label_id, xs, ys, count, offset);
+                     });
+      },
+      py::arg("label_id"), py::arg("series"), py::arg("channel") = 0,
+      py::arg("style") = nullptr,
+      "Plots a channel of a ring series as a stairstep graph.");
+}
@@ -0,0 +1,534 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <implot.h>
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "plot_kernels.hpp"
+#include "plot_style.hpp"
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// Named shared memory segment, created by one process and attached to by
+// others. The creator removes the name when done, attached processes keep
+// their mapping.
+class SharedMemory {
+public:
+  // Creates a segment of size bytes, zero filled.
+  SharedMemory(const std::string& name, size_t size)
+      : name(os_name(name)), length(size), owner(true) {
+#ifdef _WIN32
+    this->handle = CreateFileMappingA(
+        INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+        static_cast<DWORD>(size), this->name.c_str());
+    if (this->handle == nullptr || GetLastError() == ERROR_ALREADY_EXISTS) {
+      close();
+      throw std::runtime_error("Cannot create shared memory " + name + "!");
+    }
+    this->address = MapViewOfFile(this->handle, FILE_MAP_WRITE, 0, 0, size);
+#else
+    const int fd =
+        shm_open(this->name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+      throw std::runtime_error("Cannot create shared memory " + name + ": " +
+                               std::strerror(errno));
+    }
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+      void* address =
+          mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      this->address = address != MAP_FAILED ? address : nullptr;
+    }
+    ::close(fd);
+#endif
+    if (this->address == nullptr) {
+      close();
+      throw std::runtime_error("Cannot map shared memory " + name + "!");
+    }
+  }
+
+  // Attaches read-only to an existing segment.
+  explicit SharedMemory(const std::string& name)
+      : name(os_name(name)), owner(false) {
+#ifdef _WIN32
+    this->handle = OpenFileMappingA(FILE_MAP_READ, FALSE, this->name.c_str());
+    if (this->handle != nullptr) {
+      this->address = MapViewOfFile(this->handle, FILE_MAP_READ, 0, 0, 0);
+    }
+    MEMORY_BASIC_INFORMATION info;
+    if (this->address != nullptr &&
+        VirtualQuery(this->address, &info, sizeof(info)) != 0) {
+      this->length = info.RegionSize;
+    }
+#else
+    const int fd = shm_open(this->name.c_str(), O_RDONLY, 0);
+    struct stat st;
+    if (fd >= 0 && fstat(fd, &st) == 0 && st.st_size > 0) {
+      this->length = static_cast<size_t>(st.st_size);
+      void* address = mmap(nullptr, this->length, PROT_READ, MAP_SHARED, fd, 0);
+      this->address = address != MAP_FAILED ? address : nullptr;
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+#endif
+    if (this->address == nullptr) {
+      close();
+      throw std::runtime_error("Cannot attach to shared memory " + name +
+                               "!");
+    }
+  }
+
+  ~SharedMemory() { close(); }
+  SharedMemory(const SharedMemory&) = delete;
+  SharedMemory& operator=(const SharedMemory&) = delete;
+
+  // Removes a segment left behind by a creator that did not exit cleanly.
+  static void unlink(const std::string& name) {
+#ifndef _WIN32
+    shm_unlink(os_name(name).c_str());
+#else
+    // Windows removes segments with their last handle
+    (void)name;
+#endif
+  }
+
+  [[nodiscard]] void* data() const { return this->address; }
+  [[nodiscard]] size_t size() const { return this->length; }
+  [[nodiscard]] bool is_owner() const { return this->owner; }
+
+private:
+  static std::string os_name(const std::string& name) {
+#ifdef _WIN32
+    return name;
+#else
+    // POSIX names are a single path component starting with a slash
+    return !name.empty() && name[0] == '/' ? name : "/" + name;
+#endif
+  }
+
+  void close() {
+#ifdef _WIN32
+    if (this->address != nullptr) {
+      UnmapViewOfFile(this->address);
+    }
+    if (this->handle != nullptr) {
+      CloseHandle(this->handle);
+    }
+    this->handle = nullptr;
+#else
+    if (this->address != nullptr) {
+      munmap(this->address, this->length);
+    }
+    if (this->owner) {
+      shm_unlink(this->name.c_str());
+    }
+#endif
+    this->address = nullptr;
+  }
+
+  const std::string name;
+  void* address = nullptr;
+  size_t length = 0;
+  const bool owner;
+#ifdef _WIN32
+  HANDLE handle = nullptr;
+#endif
+};
+
+// Start of a SharedRing segment. It is followed by capacity x values and then
+// capacity y values per channel, all double. cursor counts the samples ever
+// written, sample i is stored at i % capacity. The writer makes sequence odd
+// before writing a batch of at most capacity / 8 samples, publishes cursor
+// after it and makes sequence even again.
+struct SharedRingHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t channels;
+  uint64_t capacity;
+  alignas(64) std::atomic<uint64_t> sequence;
+  alignas(64) std::atomic<uint64_t> cursor;
+};
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "Shared atomics must not use a process local lock");
+
+// Ring buffer of samples in shared memory, written by an acquisition process
+// and plotted in place by the GUI process. Readers never wait for the writer:
+// they plot all but the oldest capacity / 8 samples, the writer only
+// overwrites those while the plot reads. A seqlock style check after the plot
+// detects a writer that got further than that (see torn_frames).
+class SharedRing {
+public:
+  static std::unique_ptr<SharedRing> create(const std::string& name,
+                                            int capacity, int channels) {
+    if (capacity < 2 || channels <= 0) {
+      throw std::invalid_argument(
+          "Capacity must be at least 2 and channels positive!");
+    }
+    const size_t size =
+        sizeof(SharedRingHeader) +
+        sizeof(double) * static_cast<size_t>(capacity) * (1 + channels);
+    auto ring = std::unique_ptr<SharedRing>(
+        new SharedRing(std::make_unique<SharedMemory>(name, size)));
+    auto* header = ring->header;
+    header->channels = static_cast<uint32_t>(channels);
+    header->capacity = static_cast<uint64_t>(capacity);
+    header->version = version;
+    // Published last, attach() checks it
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = magic;
+    ring->init();
+    return ring;
+  }
+
+  static std::unique_ptr<SharedRing> attach(const std::string& name) {
+    auto ring = std::unique_ptr<SharedRing>(
+        new SharedRing(std::make_unique<SharedMemory>(name)));
+    const auto* header = ring->header;
+    const auto size = ring->memory->size();
+    if (size < sizeof(SharedRingHeader) || header->magic != magic ||
+        header->version != version || header->capacity < 2 ||
+        header->capacity >
+            static_cast<uint64_t>(std::numeric_limits<int>::max()) ||
+        header->channels == 0 ||
+        (size - sizeof(SharedRingHeader)) / sizeof(double) / header->capacity <
+            1 + uint64_t{header->channels}) {
+      throw std::runtime_error("Not a SharedRing: " + name + "!");
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    ring->init();
+    return ring;
+  }
+
+  void push(double x, double y) {
+    if (this->channels != 1) {
+      throw std::invalid_argument(error_channels);
+    }
+    write(1, [&](py::ssize_t, py::ssize_t, uint64_t cursor) {
+      copy(0, kernels::PackedArray<double>{&x}, 0, 1, cursor);
+      copy(1, kernels::PackedArray<double>{&y}, 0, 1, cursor);
+    });
+  }
+
+  void push(double x, const py::buffer& buffer) {
+    const auto info = buffer.request();
+    if (info.ndim != 1 || info.shape.at(0) != this->channels) {
+      throw std::invalid_argument(error_channels);
+    }
+    const auto type = ValueGetter::resolve_value_type(info);
+    write(1, [&](py::ssize_t, py::ssize_t, uint64_t cursor) {
+      copy(0, kernels::PackedArray<double>{&x}, 0, 1, cursor);
+      visit_column(info, type, 0, [&](const auto& values) {
+        for (int c = 0; c < this->channels; ++c) {
+          copy(c + 1, values, c, c + 1, cursor);
+        }
+      });
+    });
+  }
+
+  // Writes a batch of samples, ys of the shape (n,) or (n, channels).
+  void extend(const py::buffer& bufX, const py::buffer& bufY) {
+    const auto infoX = bufX.request();
+    const auto infoY = bufY.request();
+    const bool y_ok = (infoY.ndim == 1 && this->channels == 1) ||
+                      (infoY.ndim == 2 && infoY.shape.at(1) == this->channels);
+    if (infoX.ndim != 1 || !y_ok || infoX.shape.at(0) != infoY.shape.at(0)) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+    const auto typeX = ValueGetter::resolve_value_type(infoX);
+    const auto typeY = ValueGetter::resolve_value_type(infoY);
+    py::gil_scoped_release release;
+    write(infoX.shape.at(0),
+          [&](py::ssize_t first, py::ssize_t last, uint64_t cursor) {
+            visit_column(infoX, typeX, 0, [&](const auto& values) {
+              copy(0, values, first, last, cursor);
+            });
+            for (int c = 0; c < this->channels; ++c) {
+              visit_column(infoY, typeY, c, [&](const auto& values) {
+                copy(c + 1, values, first, last, cursor);
+              });
+            }
+          });
+  }
+
+  // Calls fn(getter, data, count) with the arguments for ImPlot's getter API,
+  // covering the newest samples of a channel. Counts the frame as torn if the
+  // writer may have overwritten samples while fn read them.
+  template <typename Fn> void visit(int channel, Fn&& fn) {
+    if (channel < 0 || channel >= this->channels) {
+      throw std::out_of_range("Illegal channel index.");
+    }
+    const uint64_t cursor =
+        this->header->cursor.load(std::memory_order_acquire);
+    const uint64_t count = std::min(cursor, this->capacity - this->guard);
+    RingView view{this->xs, this->ys + channel * this->capacity,
+                  this->capacity, (cursor - count) % this->capacity};
+    fn(&RingView::get, &view, static_cast<int>(count));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t sequence =
+        this->header->sequence.load(std::memory_order_relaxed);
+    const uint64_t written =
+        this->header->cursor.load(std::memory_order_relaxed) - cursor;
+    // A batch in progress may reach guard samples past the cursor
+    if (written + ((sequence & 1) != 0 ? this->guard : 0) > this->guard) {
+      ++this->tornFrames;
+    }
+  }
+
+  // Sets the x limits of the next plot to the newest history x units.
+  void set_next_plot_limits_x(double history, ImGuiCond cond) const {
+    const auto cursor = this->header->cursor.load(std::memory_order_acquire);
+    const double x_max = cursor > 0 ? last_x() : 0.0;
+    ImPlot::SetNextPlotLimitsX(x_max - history, x_max, cond);
+  }
+
+  [[nodiscard]] double last_x() const {
+    const auto cursor = this->header->cursor.load(std::memory_order_acquire);
+    if (cursor == 0) {
+      throw std::out_of_range("SharedRing is empty.");
+    }
+    return this->xs[(cursor - 1) % this->capacity];
+  }
+
+  [[nodiscard]] int get_size() const {
+    const auto cursor = this->header->cursor.load(std::memory_order_acquire);
+    return static_cast<int>(std::min(cursor, this->capacity - this->guard));
+  }
+  [[nodiscard]] uint64_t get_cursor() const {
+    return this->header->cursor.load(std::memory_order_acquire);
+  }
+  [[nodiscard]] int get_capacity() const {
+    return static_cast<int>(this->capacity);
+  }
+  [[nodiscard]] int get_channels() const { return this->channels; }
+  [[nodiscard]] uint64_t get_torn_frames() const { return this->tornFrames; }
+
+private:
+  static constexpr uint64_t magic = 0x474e49524948414dull; // "MAHIRING"
+  static constexpr uint32_t version = 1;
+  static const constexpr char* error_channels =
+      "Sample does not match the number of channels!";
+
+  // Read access to a channel in ring order for ImPlot's getter API.
+  struct RingView {
+    const double* xs;
+    const double* ys;
+    uint64_t capacity;
+    uint64_t start;
+
+    static ImPlotPoint get(void* data, int idx) {
+      const auto* view = static_cast<const RingView*>(data);
+      auto pos = view->start + static_cast<uint64_t>(idx);
+      pos = pos >= view->capacity ? pos - view->capacity : pos;
+      return ImPlotPoint(view->xs[pos], view->ys[pos]);
+    }
+  };
+
+  explicit SharedRing(std::unique_ptr<SharedMemory> memory)
+      : memory(std::move(memory)),
+        header(static_cast<SharedRingHeader*>(this->memory->data())) {}
+
+  void init() {
+    this->capacity = this->header->capacity;
+    this->channels = static_cast<int>(this->header->channels);
+    this->guard = std::max<uint64_t>(1, this->capacity / 8);
+    this->xs = reinterpret_cast<double*>(this->header + 1);
+    this->ys = this->xs + this->capacity;
+  }
+
+  // Writes count samples, only the newest capacity of them. Batches of at
+  // most guard samples are written by store(first, last, cursor), which
+  // copies the samples [first, last) to the ring starting at sample cursor.
+  template <typename Fn> void write(py::ssize_t count, Fn&& store) {
+    if (!this->memory->is_owner()) {
+      throw std::runtime_error("SharedRing is attached read-only!");
+    }
+    auto& header = *this->header;
+    uint64_t cursor = header.cursor.load(std::memory_order_relaxed);
+    const auto first = std::max<py::ssize_t>(
+        count - static_cast<py::ssize_t>(this->capacity), 0);
+    cursor += static_cast<uint64_t>(first);
+    for (auto begin = first; begin < count;) {
+      const auto end = std::min<py::ssize_t>(
+          begin + static_cast<py::ssize_t>(this->guard), count);
+      const uint64_t sequence =
+          header.sequence.load(std::memory_order_relaxed);
+      header.sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      store(begin, end, cursor);
+      cursor += static_cast<uint64_t>(end - begin);
+      header.cursor.store(cursor, std::memory_order_release);
+      header.sequence.store(sequence + 2, std::memory_order_release);
+      begin = end;
+    }
+  }
+
+  // Copies values[first, last) to a column (0 is x, 1 + c channel c),
+  // starting at sample cursor.
+  template <typename Values>
+  void copy(int column, const Values& values, py::ssize_t first,
+            py::ssize_t last, uint64_t cursor) {
+    double* ring = column == 0 ? this->xs : this->ys + (column - 1) * capacity;
+    auto pos = cursor % this->capacity;
+    for (auto i = first; i < last; ++i) {
+      ring[pos] = values[i];
+      if (++pos == this->capacity) {
+        pos = 0;
+      }
+    }
+  }
+
+  std::unique_ptr<SharedMemory> memory;
+  SharedRingHeader* header;
+  double* xs = nullptr;
+  double* ys = nullptr;
+  uint64_t capacity = 0;
+  int channels = 0;
+  // Oldest samples left out of plots, the most written in one batch
+  uint64_t guard = 1;
+  uint64_t tornFrames = 0;
+};
+
+void py_init_module_implot_shared(py::module& m) {
+  py::class_<SharedRing>(
+      m, "SharedRing",
+      "Ring buffer of samples in shared memory, for acquisition in a separate "
+      "process. The acquisition process creates it and writes, the GUI "
+      "process attaches by name and plots the samples in place. Neither "
+      "waits for the other, the oldest capacity / 8 samples are left out of "
+      "plots as room for the writer. Other languages can write to the "
+      "segment following the SharedRingHeader layout in implot_shared.cpp.")
+      .def_static("create", &SharedRing::create, py::arg("name"),
+                  py::arg("capacity"), py::arg("channels") = 1,
+                  "Creates the segment #name for writing. It is removed when "
+                  "the SharedRing is destroyed.")
+      .def_static("attach", &SharedRing::attach, py::arg("name"),
+                  "Attaches read-only to the segment #name.")
+      .def_static("unlink", &SharedMemory::unlink, py::arg("name"),
+                  "Removes a segment left behind by a crashed writer.")
+      .def("push", py::overload_cast<double, double>(&SharedRing::push),
+           py::arg("x"), py::arg("y"),
+           "Writes a sample, overwriting the oldest one if full.")
+      .def("push",
+           py::overload_cast<double, const py::buffer&>(&SharedRing::push),
+           py::arg("x"), py::arg("y"),
+           "Writes a sample with one value per channel.")
+      .def("extend", &SharedRing::extend, py::arg("xs"), py::arg("ys"),
+           "Writes a batch of samples. ys has the shape (n,) or (n, "
+           "channels). Only the newest #capacity samples are kept.")
+      .def("set_next_plot_limits_x", &SharedRing::set_next_plot_limits_x,
+           py::arg("history"), py::arg("cond") = ImGuiCond_Always,
+           "Sets the x axis limits of the next plot to show the newest "
+           "#history x units. Call right before BeginPlot().")
+      .def_property_readonly("last_x", &SharedRing::last_x,
+                             "x value of the newest sample")
+      .def_property_readonly("cursor", &SharedRing::get_cursor,
+                             "Number of samples ever written")
+      .def_property_readonly("torn_frames", &SharedRing::get_torn_frames,
+                             "Number of plots during which the writer may "
+                             "have overwritten the samples being read")
+      .def_property_readonly("capacity", &SharedRing::get_capacity)
+      .def_property_readonly("channels", &SharedRing::get_channels)
+      .def("__len__", &SharedRing::get_size);
+
+  m.def(
+      "plot_line",
+      [](const char* label_id, SharedRing& ring, int channel,
+         const ItemStyle* style) {
+        py::gil_scoped_release release;
+        ring.visit(channel, [&](auto getter, void* data, int count) {
+          apply_style(style);
+          ImPlot::PlotLineG(label_id, getter, data, count);
+        });
+      },
+      py::arg("label_id"), py::arg("ring"), py::arg("channel") = 0,
+      py::arg("style") = nullptr,
+      "Plots a channel of a shared ring as a standard 2D line plot.");
+  m.def(
+      "plot_scatter",
+      [](const char* label_id, SharedRing& ring, int channel,
+         const ItemStyle* style) {
+        py::gil_scoped_release release;
+        ring.visit(channel, [&](auto getter, void* data, int count) {
+          apply_style(style);
+          ImPlot::PlotScatterG(label_id, getter, data, count);
+        });
+      },
+      py::arg("label_id"), py::arg("ring"), py::arg("channel") = 0,
+      py::arg("style") = nullptr,
+      "Plots a channel of a shared ring as a standard 2D scatter plot.");
+  m.def(
+      "plot_stairs",
+      [](const char* label_id, SharedRing& ring, int channel,
+         const ItemStyle* style) {
+        py::gil_scoped_release release;
+        ring.visit(channel, [&](auto getter, void* data, int count) {
+          apply_style(style);
+          ImPlot::PlotStairsG(label_id, getter, data, count);
+        });
+      },
+      py::arg("label_id"), py::arg("ring"), py::arg("channel") = 0,
+      py::arg("style") = nullptr,
+      "Plots a channel of a shared ring as a stairstep graph.");
+}
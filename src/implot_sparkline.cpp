@@ -0,0 +1,245 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include <imgui.h>
+#include <implot.h>
+#include <implot_internal.h>
+#include <pybind11/pybind11.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "plot_kernels.hpp"
+#include "value_getter.hpp"
+
+namespace py = pybind11;
+
+// Rows of a 1D (one row) or 2D buffer, rows being the series.
+class SparklineRows {
+public:
+  explicit SparklineRows(const py::buffer& values)
+      : info(values.request()), type(ValueGetter::resolve_value_type(info)),
+        swapped(ValueGetter::is_byte_swapped(info)) {
+    if (this->info.ndim != 1 && this->info.ndim != 2) {
+      throw std::runtime_error("Incompatible buffer dimension!");
+    }
+  }
+
+  // Calls fn(values, count) with a kernels accessor for a row.
+  template <typename Fn> void visit(py::ssize_t row, Fn&& fn) const {
+    const auto* ptr = static_cast<const char*>(this->info.ptr);
+    if (this->info.ndim == 1) {
+      visit_values(ptr, this->info.strides.at(0), this->type, this->swapped,
+                   [&](const auto& values) { fn(values, size()); });
+    } else {
+      visit_values(ptr + row * this->info.strides.at(0),
+                   this->info.strides.at(1), this->type, this->swapped,
+                   [&](const auto& values) { fn(values, size()); });
+    }
+  }
+
+  [[nodiscard]] py::ssize_t rows() const {
+    return this->info.ndim == 1 ? 1 : this->info.shape.at(0);
+  }
+  // Values per row
+  [[nodiscard]] py::ssize_t size() const {
+    return this->info.shape.at(this->info.ndim - 1);
+  }
+
+private:
+  const py::buffer_info info;
+  const ValueType type;
+  const bool swapped;
+};
+
+// Draws a row as a line filling bb, reduced to the first, minimum, maximum
+// and last value of every pixel column (M4). NaN values are skipped. NaN
+// scale limits scale the row to its own extents.
+static void draw_sparkline(ImDrawList& draw_list, const ImRect& bb,
+                           const SparklineRows& rows, py::ssize_t row,
+                           ImU32 color, double scale_min, double scale_max) {
+  const auto width =
+      std::max<py::ssize_t>(1, static_cast<py::ssize_t>(bb.GetWidth()));
+  thread_local std::vector<double> edges;
+  edges.resize(width + 1);
+  for (py::ssize_t c = 0; c <= width; ++c) {
+    edges[c] = static_cast<double>(c) / static_cast<double>(width);
+  }
+  // x and y of every point kept
+  thread_local std::vector<double> decimated;
+  rows.visit(row, [&](const auto& values, py::ssize_t count) {
+    // x runs from 0 at the first to 1 at the last value
+    const auto span = static_cast<double>(std::max<py::ssize_t>(count - 1, 1));
+    const auto xs = kernels::make_func_array(
+        [span](std::ptrdiff_t idx) { return static_cast<double>(idx) / span; });
+    kernels::decimate_m4(xs, values, count, edges, decimated);
+  });
+  double lo = std::numeric_limits<double>::infinity();
+  double hi = -std::numeric_limits<double>::infinity();
+  for (size_t i = 1; i < decimated.size(); i += 2) {
+    lo = decimated[i] < lo ? decimated[i] : lo;
+    hi = decimated[i] > hi ? decimated[i] : hi;
+  }
+  if (lo > hi) {
+    return;
+  }
+  lo = std::isnan(scale_min) ? lo : scale_min;
+  hi = std::isnan(scale_max) ? hi : scale_max;
+  const double scale = hi > lo ? bb.GetHeight() / (hi - lo) : 0.0;
+  const double offset = hi > lo ? bb.Max.y : bb.GetCenter().y;
+  thread_local std::vector<ImVec2> points;
+  points.clear();
+  for (size_t i = 0; i < decimated.size(); i += 2) {
+    if (std::isnan(decimated[i + 1])) {
+      continue;
+    }
+    const double y = hi > lo ? std::clamp(decimated[i + 1], lo, hi) : lo;
+    points.emplace_back(
+        bb.Min.x + static_cast<float>(decimated[i] * bb.GetWidth()),
+        static_cast<float>(offset - (y - lo) * scale));
+  }
+  draw_list.AddPolyline(points.data(), static_cast<int>(points.size()), color,
+                        false, 1.0f);
+}
+
+static ImU32 sparkline_color(const ImVec4& color) {
+  return color.w < 0.0f ? ImGui::GetColorU32(ImGuiCol_PlotLines)
+                        : ImGui::ColorConvertFloat4ToU32(color);
+}
+
+// Draws a row of values as an item of its own, e.g. in a table cell.
+static void sparkline(const py::buffer& values, py::ssize_t row,
+                      const ImVec2& size, const ImVec4& color,
+                      double scale_min, double scale_max) {
+  const SparklineRows rows(values);
+  if (row < 0 || row >= rows.rows()) {
+    throw std::out_of_range("Illegal row index.");
+  }
+  py::gil_scoped_release release;
+  ImGuiWindow* window = ImGui::GetCurrentWindow();
+  if (window->SkipItems) {
+    return;
+  }
+  const ImVec2 item_size = ImGui::CalcItemSize(
+      size, ImGui::CalcItemWidth(), ImGui::GetTextLineHeight());
+  const ImVec2 pos = window->DC.CursorPos;
+  const ImRect bb(pos, ImVec2(pos.x + item_size.x, pos.y + item_size.y));
+  ImGui::ItemSize(bb);
+  if (!ImGui::ItemAdd(bb, 0)) {
+    return;
+  }
+  draw_sparkline(*window->DrawList, bb, rows, row, sparkline_color(color),
+                 scale_min, scale_max);
+}
+
+// Draws every row of values into a grid of cells as one item. Only the grid
+// rows inside the window's clip rect are drawn.
+static void sparkline_grid(const py::buffer& values, int columns,
+                           const ImVec2& cell_size, const ImVec4& color,
+                           double scale_min, double scale_max) {
+  const SparklineRows rows(values);
+  if (columns <= 0) {
+    throw std::invalid_argument("columns must be positive!");
+  }
+  py::gil_scoped_release release;
+  ImGuiWindow* window = ImGui::GetCurrentWindow();
+  if (window->SkipItems) {
+    return;
+  }
+  const ImVec2 spacing = ImGui::GetStyle().ItemSpacing;
+  const float width =
+      cell_size.x > 0.0f
+          ? cell_size.x
+          : std::max(1.0f, (ImGui::GetContentRegionAvail().x -
+                            spacing.x * static_cast<float>(columns - 1)) /
+                               static_cast<float>(columns));
+  const float height =
+      cell_size.y > 0.0f ? cell_size.y : ImGui::GetTextLineHeight();
+  const auto grid_rows = (rows.rows() + columns - 1) / columns;
+  const float pitch = height + spacing.y;
+  const ImVec2 pos = window->DC.CursorPos;
+  const float grid_width = columns * (width + spacing.x) - spacing.x;
+  const float grid_height = std::max(0.0f, grid_rows * pitch - spacing.y);
+  const ImRect bb(pos, ImVec2(pos.x + grid_width, pos.y + grid_height));
+  ImGui::ItemSize(bb);
+  if (!ImGui::ItemAdd(bb, 0)) {
+    return;
+  }
+  const ImRect& clip = window->ClipRect;
+  const auto first = std::max<py::ssize_t>(
+      0, static_cast<py::ssize_t>((clip.Min.y - pos.y) / pitch));
+  const auto last = std::min<py::ssize_t>(
+      grid_rows, static_cast<py::ssize_t>((clip.Max.y - pos.y) / pitch) + 1);
+  const ImU32 col = sparkline_color(color);
+  for (auto r = first; r < last; ++r) {
+    for (int c = 0; c < columns; ++c) {
+      const auto row = r * columns + c;
+      if (row >= rows.rows()) {
+        break;
+      }
+      const ImVec2 min(pos.x + c * (width + spacing.x), pos.y + r * pitch);
+      draw_sparkline(*window->DrawList,
+                     ImRect(min, ImVec2(min.x + width, min.y + height)), rows,
+                     row, col, scale_min, scale_max);
+    }
+  }
+}
+
+void py_init_module_implot_sparkline(py::module& m) {
+  m.def("sparkline", &sparkline, py::arg("values"), py::arg("row") = 0,
+        py::arg("size") = ImVec2(-1, 0), py::arg("color") = IMPLOT_AUTO_COL,
+        py::arg("scale_min") = NAN, py::arg("scale_max") = NAN,
+        "Draws a row of a 1D or 2D buffer as a tiny line plot item, e.g. in "
+        "a table cell next to its labels. The row is reduced to the first, "
+        "min, max and last value of each pixel column and scaled to its "
+        "extents unless #scale_min and #scale_max are given. No ImPlot plot "
+        "is created.");
+  m.def("sparkline_grid", &sparkline_grid, py::arg("values"),
+        py::arg("columns") = 1, py::arg("cell_size") = ImVec2(-1, 0),
+        py::arg("color") = IMPLOT_AUTO_COL, py::arg("scale_min") = NAN,
+        py::arg("scale_max") = NAN,
+        "Draws every row of a 2D buffer as a sparkline in a grid of "
+        "#columns cells per line, as a single item. Only the visible cells "
+        "are drawn, each reduced to its pixel width. The default cell is as "
+        "high as a line of text and splits the available width.");
+}
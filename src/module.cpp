@@ -47,6 +47,14 @@ void py_init_module_mahi_gui(py::module&);
 void py_init_module_imgui(py::module&);
 void py_init_module_imgui_custom(py::module&);
 void py_init_module_implot(py::module&);
+void py_init_module_implot_series(py::module&);
+void py_init_module_implot_heatmap(py::module&);
+void py_init_module_implot_digital(py::module&);
+void py_init_module_implot_pyramid(py::module&);
+void py_init_module_implot_mapped(py::module&);
+void py_init_module_implot_loader(py::module&);
+void py_init_module_implot_shared(py::module&);
+void py_init_module_implot_sparkline(py::module&);
 
 PYBIND11_MODULE(mahi_gui, m) {
 #ifdef VERSION_INFO
@@ -60,4 +68,12 @@ PYBIND11_MODULE(mahi_gui, m) {
   py_init_module_imgui(imgui);
   py_init_module_imgui_custom(imgui);
   py_init_module_implot(implot);
+  py_init_module_implot_series(implot);
+  py_init_module_implot_heatmap(implot);
+  py_init_module_implot_digital(implot);
+  py_init_module_implot_pyramid(implot);
+  py_init_module_implot_mapped(implot);
+  py_init_module_implot_loader(implot);
+  py_init_module_implot_shared(implot);
+  py_init_module_implot_sparkline(implot);
 }
\ No newline at end of file
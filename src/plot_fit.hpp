@@ -0,0 +1,98 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_FIT_HPP
+#define _PLOT_FIT_HPP
+
+#include <implot.h>
+#include <implot_internal.h>
+
+// Whether BeginItem() will show the item label_id, i.e. it is not hidden
+// through the legend or HideNextItem().
+inline bool is_next_item_shown(const char* label_id) {
+  const ImPlotContext& gp = *GImPlot;
+  const ImPlotItem* item = ImPlot::GetItem(label_id);
+  const ImPlotNextItemData& next = gp.NextItemData;
+  if (next.HasHidden &&
+      (item == nullptr || next.HiddenCond == ImGuiCond_Always)) {
+    return !next.Hidden;
+  }
+  return item == nullptr || item->Show;
+}
+
+// While the current plot is being fit, feeds ImPlot the precomputed extents
+// of the next item label_id and keeps the item from scanning all of its
+// values for them. extents_fn() is only called when fitting. Hidden items do
+// not take part, as in ImPlot. Log axes are left to ImPlot, which skips
+// non-positive values there.
+class CachedFit {
+public:
+  template <typename ExtentsFn>
+  CachedFit(const char* label_id, ExtentsFn&& extents_fn) {
+    ImPlotContext& gp = *GImPlot;
+    if (!gp.FitThisFrame || !is_next_item_shown(label_id)) {
+      return;
+    }
+    const ImPlotPlot& plot = *gp.CurrentPlot;
+    if (ImHasFlag(plot.XAxis.Flags, ImPlotAxisFlags_LogScale) ||
+        ImHasFlag(plot.YAxis[plot.CurrentYAxis].Flags,
+                  ImPlotAxisFlags_LogScale)) {
+      return;
+    }
+    const ImPlotLimits& extents = extents_fn();
+    ImPlot::FitPoint(ImPlotPoint(extents.X.Min, extents.Y.Min));
+    ImPlot::FitPoint(ImPlotPoint(extents.X.Max, extents.Y.Max));
+    gp.FitThisFrame = false;
+    this->active = true;
+  }
+  ~CachedFit() {
+    if (this->active) {
+      GImPlot->FitThisFrame = true;
+    }
+  }
+  CachedFit(const CachedFit&) = delete;
+  CachedFit& operator=(const CachedFit&) = delete;
+
+private:
+  bool active = false;
+};
+
+#endif
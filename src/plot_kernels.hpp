@@ -0,0 +1,457 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_KERNELS_HPP
+#define _PLOT_KERNELS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Data reduction kernels operating on typed buffer accessors. They do not
+// depend on ImPlot or pybind11, output is written as interleaved x/y doubles.
+namespace kernels {
+
+// Data reduction applied to line plots before handing them to ImPlot.
+enum class Decimation { None, M4, LTTB };
+
+// Read access to a strided 1D buffer of type T.
+template <typename T> struct StridedArray {
+  const char* data;
+  std::ptrdiff_t stride;
+
+  double operator[](std::ptrdiff_t idx) const {
+    return static_cast<double>(
+        *reinterpret_cast<const T*>(data + idx * stride));
+  }
+};
+
+// Reverses the byte order of value. Compilers turn this into a bswap.
+template <typename T> T byte_swap(T value) {
+  unsigned char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  std::reverse(bytes, bytes + sizeof(T));
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+// Read access to a strided 1D buffer of type T in non-native byte order.
+template <typename T> struct SwappedArray {
+  const char* data;
+  std::ptrdiff_t stride;
+
+  double operator[](std::ptrdiff_t idx) const {
+    T value;
+    std::memcpy(&value, data + idx * stride, sizeof(T));
+    return static_cast<double>(byte_swap(value));
+  }
+};
+
+// Read access to a packed 1D buffer of type T, lets the compiler vectorize.
+template <typename T> struct PackedArray {
+  const T* data;
+
+  double operator[](std::ptrdiff_t idx) const {
+    return static_cast<double>(data[idx]);
+  }
+};
+
+// The index (plus an offset) itself, used for x when only y values are given.
+struct IndexArray {
+  std::ptrdiff_t offset = 0;
+
+  double operator[](std::ptrdiff_t idx) const {
+    return static_cast<double>(offset + idx);
+  }
+};
+
+// Wraps a callable returning the value at an index.
+template <typename Fn> struct FuncArray {
+  Fn fn;
+
+  double operator[](std::ptrdiff_t idx) const { return fn(idx); }
+};
+template <typename Fn> FuncArray<Fn> make_func_array(Fn fn) { return {fn}; }
+
+// Returns the first index in [first, last) for which pred(xs[idx]) is false.
+// xs must be partitioned with respect to pred.
+template <typename Xs, typename Pred>
+std::ptrdiff_t partition_point(const Xs& xs, std::ptrdiff_t first,
+                               std::ptrdiff_t last, Pred pred) {
+  auto count = last - first;
+  while (count > 0) {
+    const auto step = count / 2;
+    const auto mid = first + step;
+    if (pred(xs[mid])) {
+      first = mid + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  return first;
+}
+
+// First index in [first, last) with xs[idx] >= value, xs sorted ascending.
+template <typename Xs>
+std::ptrdiff_t lower_bound(const Xs& xs, std::ptrdiff_t first,
+                           std::ptrdiff_t last, double value) {
+  return partition_point(xs, first, last,
+                         [value](double x) { return x < value; });
+}
+
+// First index in [first, last) with xs[idx] > value, xs sorted ascending.
+template <typename Xs>
+std::ptrdiff_t upper_bound(const Xs& xs, std::ptrdiff_t first,
+                           std::ptrdiff_t last, double value) {
+  return partition_point(xs, first, last,
+                         [value](double x) { return !(value < x); });
+}
+
+template <typename Xs> bool is_sorted(const Xs& xs, std::ptrdiff_t count) {
+  for (std::ptrdiff_t i = 1; i < count; ++i) {
+    if (xs[i] < xs[i - 1]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether xs[idx] == x0 + idx * dx (up to rounding) and sets x0 and dx.
+template <typename Xs>
+bool is_uniform(const Xs& xs, std::ptrdiff_t count, double& x0, double& dx) {
+  x0 = count > 0 ? xs[0] : 0.0;
+  dx = count > 1 ? (xs[count - 1] - x0) / static_cast<double>(count - 1) : 1.0;
+  const double tolerance = 1e-6 * std::abs(dx);
+  for (std::ptrdiff_t i = 1; i < count - 1; ++i) {
+    if (!(std::abs(xs[i] - (x0 + i * dx)) <= tolerance)) {
+      return false;
+    }
+  }
+  return dx != 0.0 || count <= 1;
+}
+
+// Minimum and maximum of ys[first, last), ignoring NaN. Returns (inf, -inf)
+// if there are no such values. Uses independent accumulators so the loop can
+// be vectorized.
+template <typename Ys>
+std::pair<double, double> min_max(const Ys& ys, std::ptrdiff_t first,
+                                  std::ptrdiff_t last) {
+  double lo[4], hi[4];
+  for (int k = 0; k < 4; ++k) {
+    lo[k] = std::numeric_limits<double>::infinity();
+    hi[k] = -std::numeric_limits<double>::infinity();
+  }
+  std::ptrdiff_t i = first;
+  for (; i + 4 <= last; i += 4) {
+    for (int k = 0; k < 4; ++k) {
+      const double y = ys[i + k];
+      lo[k] = y < lo[k] ? y : lo[k];
+      hi[k] = y > hi[k] ? y : hi[k];
+    }
+  }
+  for (; i < last; ++i) {
+    const double y = ys[i];
+    lo[0] = y < lo[0] ? y : lo[0];
+    hi[0] = y > hi[0] ? y : hi[0];
+  }
+  return {std::min(std::min(lo[0], lo[1]), std::min(lo[2], lo[3])),
+          std::max(std::max(hi[0], hi[1]), std::max(hi[2], hi[3]))};
+}
+
+template <typename Ys>
+std::ptrdiff_t find(const Ys& ys, std::ptrdiff_t first, std::ptrdiff_t last,
+                    double value) {
+  for (; first < last; ++first) {
+    if (ys[first] == value) {
+      return first;
+    }
+  }
+  return last;
+}
+
+namespace detail {
+template <typename Xs, typename Ys>
+inline void emit(const Xs& xs, const Ys& ys, std::ptrdiff_t idx,
+                 std::vector<double>& out) {
+  out.push_back(xs[idx]);
+  out.push_back(ys[idx]);
+}
+
+// Emits first, min, max and last point of [first, last) in index order.
+template <typename Xs, typename Ys>
+void emit_m4(const Xs& xs, const Ys& ys, std::ptrdiff_t first,
+             std::ptrdiff_t last, std::vector<double>& out) {
+  if (last - first <= 4) {
+    for (auto i = first; i < last; ++i) {
+      emit(xs, ys, i, out);
+    }
+    return;
+  }
+  const auto [lo, hi] = min_max(ys, first, last);
+  auto i_lo = find(ys, first, last, lo);
+  auto i_hi = find(ys, first, last, hi);
+  if (i_lo == last || i_hi == last) {
+    // NaN in the column, keep the outline at least
+    i_lo = i_hi = first;
+  }
+  const auto i_a = std::min(i_lo, i_hi);
+  const auto i_b = std::max(i_lo, i_hi);
+  emit(xs, ys, first, out);
+  if (i_a != first) {
+    emit(xs, ys, i_a, out);
+  }
+  if (i_b != i_a && i_b != last - 1) {
+    emit(xs, ys, i_b, out);
+  }
+  emit(xs, ys, last - 1, out);
+}
+} // namespace detail
+
+// M4 decimation: keeps the first, minimum, maximum and last point of every
+// column between consecutive edges (ascending x values, usually one per
+// pixel). The last point left of and the first point right of the edges are
+// kept so lines leave the visible area correctly. xs must be sorted.
+template <typename Xs, typename Ys>
+void decimate_m4(const Xs& xs, const Ys& ys, std::ptrdiff_t count,
+                 const std::vector<double>& edges, std::vector<double>& out) {
+  out.clear();
+  if (count <= 0 || edges.size() < 2) {
+    return;
+  }
+  auto first = lower_bound(xs, 0, count, edges.front());
+  const auto end = upper_bound(xs, first, count, edges.back());
+  if (first > 0) {
+    detail::emit(xs, ys, first - 1, out);
+  }
+  for (std::size_t c = 1; c < edges.size() && first < end; ++c) {
+    const auto last = c + 1 == edges.size()
+                          ? end
+                          : lower_bound(xs, first, end, edges[c]);
+    if (last > first) {
+      detail::emit_m4(xs, ys, first, last, out);
+      first = last;
+    }
+  }
+  if (end < count) {
+    detail::emit(xs, ys, end, out);
+  }
+}
+
+// Largest-Triangle-Three-Buckets decimation of [first, last) down to
+// threshold points. The first and last point are always kept.
+template <typename Xs, typename Ys>
+void decimate_lttb(const Xs& xs, const Ys& ys, std::ptrdiff_t first,
+                   std::ptrdiff_t last, std::ptrdiff_t threshold,
+                   std::vector<double>& out) {
+  out.clear();
+  const auto count = last - first;
+  if (count <= 0) {
+    return;
+  }
+  if (threshold < 3 || count <= threshold) {
+    out.reserve(2 * count);
+    for (auto i = first; i < last; ++i) {
+      detail::emit(xs, ys, i, out);
+    }
+    return;
+  }
+  out.reserve(2 * threshold);
+  const double bucket = static_cast<double>(count - 2) / (threshold - 2);
+  auto bucket_begin = [&](std::ptrdiff_t b) {
+    return first + 1 + static_cast<std::ptrdiff_t>(b * bucket);
+  };
+
+  auto a = first;
+  detail::emit(xs, ys, a, out);
+  for (std::ptrdiff_t b = 0; b < threshold - 2; ++b) {
+    // Average of the next bucket is the third triangle corner
+    const auto next_begin = bucket_begin(b + 1);
+    const auto next_end = std::min(bucket_begin(b + 2), last);
+    double avg_x = 0.0, avg_y = 0.0;
+    if (next_begin < next_end) {
+      for (auto i = next_begin; i < next_end; ++i) {
+        avg_x += xs[i];
+        avg_y += ys[i];
+      }
+      avg_x /= static_cast<double>(next_end - next_begin);
+      avg_y /= static_cast<double>(next_end - next_begin);
+    } else {
+      avg_x = xs[last - 1];
+      avg_y = ys[last - 1];
+    }
+
+    const double ax = xs[a];
+    const double ay = ys[a];
+    double max_area = -1.0;
+    auto picked = bucket_begin(b);
+    for (auto i = bucket_begin(b), end = bucket_begin(b + 1); i < end; ++i) {
+      // Twice the triangle area, the factor does not matter for comparison
+      const double area =
+          std::abs((ax - avg_x) * (ys[i] - ay) - (ax - xs[i]) * (avg_y - ay));
+      if (area > max_area) {
+        max_area = area;
+        picked = i;
+      }
+    }
+    detail::emit(xs, ys, picked, out);
+    a = picked;
+  }
+  detail::emit(xs, ys, last - 1, out);
+}
+
+// Decimates xs and ys to the columns between consecutive edges (ascending x
+// values, usually one per pixel), with M4 or with LTTB down to two points per
+// column. Points outside the edges are dropped except for one on each side,
+// so lines leave the visible area correctly. xs must be sorted.
+template <typename Xs, typename Ys>
+void decimate_columns(const Xs& xs, const Ys& ys, std::ptrdiff_t count,
+                      Decimation mode, const std::vector<double>& edges,
+                      std::vector<double>& out) {
+  if (mode == Decimation::M4) {
+    decimate_m4(xs, ys, count, edges, out);
+    return;
+  }
+  auto first = lower_bound(xs, 0, count, edges.front());
+  auto last = upper_bound(xs, first, count, edges.back());
+  first = std::max<std::ptrdiff_t>(first - 1, 0);
+  last = std::min<std::ptrdiff_t>(last + 1, count);
+  const auto columns = static_cast<std::ptrdiff_t>(edges.size()) - 1;
+  decimate_lttb(xs, ys, first, last, 2 * columns, out);
+}
+
+// Rows of packed channel bits, e.g. the output of np.packbits() or raw port
+// reads. Channel c is in byte c / 8 of a row (counted from the end if the
+// bytes are reversed, e.g. a byte swapped integer), as bit c % 8 counted from
+// the least significant bit or, with big bit order, from the most
+// significant one.
+struct PackedRows {
+  const unsigned char* data;
+  std::ptrdiff_t stride;
+  int rowBytes;
+  bool bigBitOrder;
+  bool reversedBytes;
+
+  [[nodiscard]] int channels() const { return 8 * this->rowBytes; }
+
+  [[nodiscard]] bool bit(std::ptrdiff_t row, int channel) const {
+    const int byte = channel / 8;
+    const int bit = channel % 8;
+    const unsigned char value =
+        this->data[row * this->stride +
+                   (this->reversedBytes ? this->rowBytes - 1 - byte : byte)];
+    return ((value >> (this->bigBitOrder ? 7 - bit : bit)) & 1) != 0;
+  }
+
+  // Channel of bit (counted from the least significant one) of the memory
+  // byte byte of a row.
+  [[nodiscard]] int channel(int byte, int bit) const {
+    if (this->reversedBytes) {
+      byte = this->rowBytes - 1 - byte;
+    }
+    return 8 * byte + (this->bigBitOrder ? 7 - bit : bit);
+  }
+
+  // Bytes 8 * word ... 8 * word + 7 of a row, the first one in the lowest
+  // bits as on little-endian machines.
+  [[nodiscard]] uint64_t word(std::ptrdiff_t row, int word) const {
+    const unsigned char* bytes = this->data + row * this->stride + 8 * word;
+    const int count = std::min(8, this->rowBytes - 8 * word);
+    uint64_t value = 0;
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (count == 8) {
+      std::memcpy(&value, bytes, 8);
+      return value;
+    }
+#endif
+    for (int i = 0; i < count; ++i) {
+      value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return value;
+  }
+};
+
+inline int count_trailing_zeros(uint64_t value) {
+#ifdef _MSC_VER
+  unsigned long idx;
+  _BitScanForward64(&idx, value);
+  return static_cast<int>(idx);
+#else
+  return __builtin_ctzll(value);
+#endif
+}
+
+// Calls fn(row, channel) for every channel whose bit in row differs from the
+// previous row, for the rows (first, last). The rows of a channel come in
+// ascending order. Rows are compared 64 channels at a time, so stretches
+// without transitions cost one XOR per row and word.
+template <typename Fn>
+void for_each_transition(const PackedRows& rows, std::ptrdiff_t first,
+                         std::ptrdiff_t last, Fn&& fn) {
+  const int words = (rows.rowBytes + 7) / 8;
+  for (int w = 0; w < words; ++w) {
+    if (last - first < 2) {
+      break;
+    }
+    uint64_t prev = rows.word(first, w);
+    for (auto row = first + 1; row < last; ++row) {
+      const uint64_t value = rows.word(row, w);
+      for (uint64_t diff = value ^ prev; diff != 0; diff &= diff - 1) {
+        const int bit = 64 * w + count_trailing_zeros(diff);
+        fn(row, rows.channel(bit / 8, bit % 8));
+      }
+      prev = value;
+    }
+  }
+}
+
+} // namespace kernels
+
+#endif
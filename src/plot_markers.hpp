@@ -0,0 +1,222 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_MARKERS_HPP
+#define _PLOT_MARKERS_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <imgui.h>
+#include <implot.h>
+#include <implot_internal.h>
+#include <limits>
+#include <vector>
+
+#include "plot_transform.hpp"
+
+namespace detail {
+
+// Appends a copy of the marker geometry at every center, splitting the copies
+// into draw commands that fit ImDrawIdx.
+inline void append_markers(ImDrawList& draw_list,
+                           const std::vector<ImDrawVert>& vertices,
+                           const std::vector<unsigned int>& indices,
+                           const ImVec2* centers, size_t count) {
+  constexpr unsigned int max_idx = std::numeric_limits<ImDrawIdx>::max();
+  const auto vtx_n = static_cast<unsigned int>(vertices.size());
+  const auto idx_n = static_cast<unsigned int>(indices.size());
+  while (count > 0) {
+    unsigned int room = (max_idx - draw_list._VtxCurrentIdx) / vtx_n;
+    if (room == 0) {
+      // PrimReserve() starts a new vertex offset
+      room = max_idx / vtx_n;
+    }
+    const auto n = static_cast<unsigned int>(std::min<size_t>(room, count));
+    draw_list.PrimReserve(static_cast<int>(n * idx_n),
+                          static_cast<int>(n * vtx_n));
+    for (unsigned int m = 0; m < n; ++m, ++centers) {
+      const ImVec2 c = *centers;
+      ImDrawVert* vtx = draw_list._VtxWritePtr;
+      std::memcpy(vtx, vertices.data(), vtx_n * sizeof(ImDrawVert));
+      for (unsigned int v = 0; v < vtx_n; ++v) {
+        vtx[v].pos.x += c.x;
+        vtx[v].pos.y += c.y;
+      }
+      const auto base = draw_list._VtxCurrentIdx;
+      for (unsigned int i = 0; i < idx_n; ++i) {
+        draw_list._IdxWritePtr[i] = static_cast<ImDrawIdx>(base + indices[i]);
+      }
+      draw_list._VtxWritePtr += vtx_n;
+      draw_list._IdxWritePtr += idx_n;
+      draw_list._VtxCurrentIdx += vtx_n;
+    }
+    count -= n;
+  }
+}
+
+// Replaces a marker smaller than a couple of pixels by a single quad of its
+// color, at least one pixel wide.
+inline void shrink_to_quad(std::vector<ImDrawVert>& vertices,
+                           std::vector<unsigned int>& indices) {
+  float radius = 0.0f;
+  const ImDrawVert* opaque = nullptr;
+  for (const auto& v : vertices) {
+    // Anti-aliasing fringes are transparent
+    if ((v.col & IM_COL32_A_MASK) != 0) {
+      radius = ImMax(radius, ImMax(ImFabs(v.pos.x), ImFabs(v.pos.y)));
+      opaque = opaque != nullptr ? opaque : &v;
+    }
+  }
+  if (opaque == nullptr || radius >= 1.5f) {
+    return;
+  }
+  const float r = ImMax(0.5f, radius);
+  const ImVec2 uv = opaque->uv;
+  const ImU32 col = opaque->col;
+  vertices = {{ImVec2(-r, -r), uv, col},
+              {ImVec2(r, -r), uv, col},
+              {ImVec2(r, r), uv, col},
+              {ImVec2(-r, r), uv, col}};
+  indices = {0, 1, 2, 0, 2, 3};
+}
+
+} // namespace detail
+
+// Plots getter(0) ... getter(count - 1), with getter(idx) returning an
+// ImPlotPoint, as a scatter item without tessellating every marker. ImPlot
+// plots the first visible point, its geometry is the template copied to all
+// other points. Shape, size, colors and anti-aliasing are therefore ImPlot's.
+// Markers of at most a couple of pixels become one quad, and points on a pixel
+// that already has a marker are skipped. Returns false without plotting if
+// the item has to be left to ImPlot, e.g. while the plot is being fit.
+template <typename Getter>
+bool plot_scatter_fast(const char* label_id, const Getter& getter,
+                       int count) {
+  ImPlotContext& gp = *GImPlot;
+  ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+  // The template must not straddle a new vertex offset
+  if (gp.FitThisFrame || count == 0 ||
+      (sizeof(ImDrawIdx) == 2 && draw_list._VtxCurrentIdx > 60000)) {
+    return false;
+  }
+  const ImRect bb = gp.BB_Plot;
+  const PlotTransform transform;
+
+  // Pixel positions of the visible points, one per pixel
+  const int width = static_cast<int>(bb.GetWidth()) + 1;
+  const int height = static_cast<int>(bb.GetHeight()) + 1;
+  thread_local std::vector<uint64_t> covered;
+  covered.assign((static_cast<size_t>(width) * height + 63) / 64, 0);
+  thread_local std::vector<ImVec2> centers;
+  centers.clear();
+  int first_visible = -1;
+  constexpr int batch = 512;
+  double xs[batch];
+  double ys[batch];
+  float px[batch];
+  float py[batch];
+  for (int begin = 0; begin < count; begin += batch) {
+    const int n = std::min(batch, count - begin);
+    for (int i = 0; i < n; ++i) {
+      const ImPlotPoint point = getter(begin + i);
+      xs[i] = point.x;
+      ys[i] = point.y;
+    }
+    transform.apply(xs, ys, n, px, py);
+    for (int i = 0; i < n; ++i) {
+      const ImVec2 c(px[i], py[i]);
+      if (!bb.Contains(c)) {
+        continue;
+      }
+      const auto pixel =
+          static_cast<size_t>(static_cast<int>(c.y - bb.Min.y)) * width +
+          static_cast<int>(c.x - bb.Min.x);
+      uint64_t& word = covered[pixel / 64];
+      const uint64_t bit = uint64_t{1} << (pixel % 64);
+      if ((word & bit) == 0) {
+        word |= bit;
+        if (first_visible < 0) {
+          first_visible = begin + i;
+        }
+        centers.push_back(c);
+      }
+    }
+  }
+
+  // ImPlot plots one point, for the legend and the template
+  const ImPlotPoint first = getter(std::max(first_visible, 0));
+  const int vtx_begin = draw_list.VtxBuffer.Size;
+  const int idx_begin = draw_list.IdxBuffer.Size;
+  const auto vtx_index_begin = draw_list._VtxCurrentIdx;
+  ImPlot::PlotScatter(label_id, &first.x, &first.y, 1);
+  const int vtx_count = draw_list.VtxBuffer.Size - vtx_begin;
+  if (first_visible < 0 || vtx_count == 0 ||
+      draw_list._VtxCurrentIdx - vtx_index_begin !=
+          static_cast<unsigned int>(vtx_count)) {
+    return true;
+  }
+  thread_local std::vector<ImDrawVert> vertices;
+  thread_local std::vector<unsigned int> indices;
+  const ImVec2 c0 = centers.front();
+  vertices.assign(draw_list.VtxBuffer.Data + vtx_begin,
+                  draw_list.VtxBuffer.Data + draw_list.VtxBuffer.Size);
+  float radius = 0.0f;
+  for (auto& v : vertices) {
+    v.pos.x -= c0.x;
+    v.pos.y -= c0.y;
+    radius = ImMax(radius, ImMax(ImFabs(v.pos.x), ImFabs(v.pos.y)));
+  }
+  indices.resize(draw_list.IdxBuffer.Size - idx_begin);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = draw_list.IdxBuffer.Data[idx_begin + i] - vtx_index_begin;
+  }
+  detail::shrink_to_quad(vertices, indices);
+
+  // ImPlot clips markers to the plot area grown by their size
+  draw_list.PushClipRect(ImVec2(bb.Min.x - radius, bb.Min.y - radius),
+                         ImVec2(bb.Max.x + radius, bb.Max.y + radius), true);
+  detail::append_markers(draw_list, vertices, indices, centers.data() + 1,
+                         centers.size() - 1);
+  draw_list.PopClipRect();
+  return true;
+}
+
+#endif
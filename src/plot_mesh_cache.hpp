@@ -0,0 +1,209 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_MESH_CACHE_HPP
+#define _PLOT_MESH_CACHE_HPP
+
+#include <array>
+#include <cstring>
+#include <imgui.h>
+#include <implot.h>
+#include <implot_internal.h>
+#include <vector>
+
+// Retained draw list geometry of plotted items. If nothing that affects an
+// item's geometry changed since an earlier frame (data version, plot limits,
+// position and size, axis flags, the item's resolved style), the recorded
+// vertices and indices are appended again instead of plotting the data.
+class MeshCache {
+public:
+  // Plots the item with plot_fn() or replays its geometry. kind tells apart
+  // plot functions (and options) used with the same label, recolor_from is
+  // the style color ImPlot recolors the item from. Replays are drawn under
+  // the item's clip rect, plot_fn() must not push its own.
+  template <typename PlotFn>
+  void plot(const char* label_id, uint64_t version, int kind,
+            ImPlotCol recolor_from, PlotFn&& plot_fn) {
+    ImPlotContext& gp = *GImPlot;
+    if (gp.FitThisFrame) {
+      plot_fn();
+      return;
+    }
+    // BeginItem() resolves the item's style for the key. It also consumes
+    // the next item data, which plot_fn() still needs on a miss.
+    const ImPlotNextItemData next_item_data = gp.NextItemData;
+    if (!ImPlot::BeginItem(label_id, recolor_from)) {
+      return;
+    }
+    const Key key = make_key(label_id, version, kind);
+    ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+    for (auto& entry : this->entries) {
+      if (entry.valid && entry.key == key) {
+        replay(entry, draw_list);
+        entry.lastUsed = ImGui::GetFrameCount();
+        ImPlot::EndItem();
+        return;
+      }
+    }
+    ImPlot::EndItem();
+    gp.NextItemData = next_item_data;
+
+    const int vtx_begin = draw_list.VtxBuffer.Size;
+    const int idx_begin = draw_list.IdxBuffer.Size;
+    const auto vtx_index_begin = draw_list._VtxCurrentIdx;
+    plot_fn();
+    const int vtx_count = draw_list.VtxBuffer.Size - vtx_begin;
+    // Geometry that had to start a new vertex offset (16 bit indices) can not
+    // be rebased as a whole and is not kept.
+    if (draw_list._VtxCurrentIdx - vtx_index_begin !=
+        static_cast<unsigned int>(vtx_count)) {
+      return;
+    }
+    Entry& entry = least_recently_used();
+    entry.valid = true;
+    entry.key = key;
+    entry.lastUsed = ImGui::GetFrameCount();
+    entry.vertices.assign(draw_list.VtxBuffer.Data + vtx_begin,
+                          draw_list.VtxBuffer.Data + draw_list.VtxBuffer.Size);
+    entry.indices.resize(draw_list.IdxBuffer.Size - idx_begin);
+    for (size_t i = 0; i < entry.indices.size(); ++i) {
+      entry.indices[i] =
+          draw_list.IdxBuffer.Data[idx_begin + i] - vtx_index_begin;
+    }
+  }
+
+  void clear() { this->entries = {}; }
+
+private:
+  // Everything the geometry depends on, flattened for comparison.
+  using Key = std::vector<double>;
+
+  struct Entry {
+    bool valid = false;
+    Key key;
+    int lastUsed = 0;
+    std::vector<ImDrawVert> vertices;
+    std::vector<unsigned int> indices;
+  };
+
+  static Key make_key(const char* label_id, uint64_t version, int kind) {
+    const ImPlotContext& gp = *GImPlot;
+    const ImPlotPlot& plot = *gp.CurrentPlot;
+    const ImPlotNextItemData& style = gp.NextItemData;
+    const ImPlotLimits limits = ImPlot::GetPlotLimits();
+    const ImVec2 pos = ImPlot::GetPlotPos();
+    const ImVec2 size = ImPlot::GetPlotSize();
+    const ImVec2 white_uv = ImGui::GetFontTexUvWhitePixel();
+    Key key;
+    key.reserve(48);
+    auto add = [&](double value) { key.push_back(value); };
+    add(ImGui::GetID(label_id));
+    add(static_cast<double>(version));
+    add(kind);
+    add(limits.X.Min);
+    add(limits.X.Max);
+    add(limits.Y.Min);
+    add(limits.Y.Max);
+    add(pos.x);
+    add(pos.y);
+    add(size.x);
+    add(size.y);
+    add(white_uv.x);
+    add(white_uv.y);
+    add(plot.XAxis.Flags);
+    add(plot.YAxis[plot.CurrentYAxis].Flags);
+    add(gp.Style.AntiAliasedLines);
+    for (const auto& color : style.Colors) {
+      add(color.x);
+      add(color.y);
+      add(color.z);
+      add(color.w);
+    }
+    add(style.LineWeight);
+    add(style.Marker);
+    add(style.MarkerSize);
+    add(style.MarkerWeight);
+    add(style.FillAlpha);
+    add(style.RenderLine);
+    add(style.RenderFill);
+    add(style.RenderMarkerLine);
+    add(style.RenderMarkerFill);
+    return key;
+  }
+
+  static void replay(const Entry& entry, ImDrawList& draw_list) {
+    if (entry.indices.empty()) {
+      return;
+    }
+    const auto vtx_count = static_cast<int>(entry.vertices.size());
+    const auto idx_count = static_cast<int>(entry.indices.size());
+    draw_list.PrimReserve(idx_count, vtx_count);
+    const auto base = draw_list._VtxCurrentIdx;
+    std::memcpy(draw_list._VtxWritePtr, entry.vertices.data(),
+                vtx_count * sizeof(ImDrawVert));
+    for (int i = 0; i < idx_count; ++i) {
+      draw_list._IdxWritePtr[i] =
+          static_cast<ImDrawIdx>(base + entry.indices[i]);
+    }
+    draw_list._VtxWritePtr += vtx_count;
+    draw_list._IdxWritePtr += idx_count;
+    draw_list._VtxCurrentIdx += vtx_count;
+  }
+
+  Entry& least_recently_used() {
+    Entry* result = &this->entries[0];
+    for (auto& entry : this->entries) {
+      if (!entry.valid) {
+        return entry;
+      }
+      if (entry.lastUsed < result->lastUsed) {
+        result = &entry;
+      }
+    }
+    return *result;
+  }
+
+  // A series is usually plotted once per frame, a few entries cover it being
+  // shown in several plots or with several plot functions.
+  std::array<Entry, 4> entries;
+};
+
+#endif
@@ -0,0 +1,197 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_PARALLEL_HPP
+#define _PLOT_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <imgui.h>
+#include <implot.h>
+#include <implot_internal.h>
+#include <limits>
+#include <vector>
+
+#include "plot_transform.hpp"
+#include "worker_pool.hpp"
+
+// Whether the next line item can be tessellated outside of ImPlot. ImPlot
+// uses the same quads per segment unless anti-aliasing or markers are on,
+// and it scans the points itself while the plot is being fit.
+inline bool can_plot_line_parallel() {
+  const ImPlotContext& gp = *GImPlot;
+  const int marker =
+      gp.NextItemData.Marker < 0 ? gp.Style.Marker : gp.NextItemData.Marker;
+  return !gp.FitThisFrame && marker == ImPlotMarker_None &&
+         !gp.Style.AntiAliasedLines &&
+         !ImHasFlag(gp.CurrentPlot->Flags, ImPlotFlags_AntiAliased);
+}
+
+namespace detail {
+
+// Quad of a line segment, the vertices ImPlot's AddLine() writes.
+inline void add_segment(std::vector<ImDrawVert>& out, const ImVec2& p1,
+                        const ImVec2& p2, float weight, ImU32 col,
+                        const ImVec2& uv) {
+  float dx = p2.x - p1.x;
+  float dy = p2.y - p1.y;
+  const float d2 = dx * dx + dy * dy;
+  if (d2 > 0.0f) {
+    const float inv_len = 1.0f / ImSqrt(d2);
+    dx *= inv_len;
+    dy *= inv_len;
+  }
+  dx *= weight * 0.5f;
+  dy *= weight * 0.5f;
+  out.push_back({ImVec2(p1.x + dy, p1.y - dx), uv, col});
+  out.push_back({ImVec2(p2.x + dy, p2.y - dx), uv, col});
+  out.push_back({ImVec2(p2.x - dy, p2.y + dx), uv, col});
+  out.push_back({ImVec2(p1.x - dy, p1.y + dx), uv, col});
+}
+
+// Appends quads to the draw list, starting a new draw command (vertex offset)
+// whenever the indices would overflow ImDrawIdx, like ImPlot's
+// RenderPrimitives().
+inline void append_quads(ImDrawList& draw_list,
+                         const std::vector<ImDrawVert>& vertices) {
+  constexpr unsigned int max_idx = std::numeric_limits<ImDrawIdx>::max();
+  const ImDrawVert* src = vertices.data();
+  auto quads = static_cast<unsigned int>(vertices.size() / 4);
+  while (quads > 0) {
+    unsigned int count =
+        std::min(quads, (max_idx - draw_list._VtxCurrentIdx) / 4);
+    if (count < std::min(64u, quads)) {
+      count = std::min(quads, max_idx / 4);
+    }
+    draw_list.PrimReserve(count * 6, count * 4);
+    std::memcpy(draw_list._VtxWritePtr, src, count * 4 * sizeof(ImDrawVert));
+    ImDrawIdx* idx = draw_list._IdxWritePtr;
+    auto base = draw_list._VtxCurrentIdx;
+    for (unsigned int q = 0; q < count; ++q, idx += 6, base += 4) {
+      idx[0] = static_cast<ImDrawIdx>(base);
+      idx[1] = static_cast<ImDrawIdx>(base + 1);
+      idx[2] = static_cast<ImDrawIdx>(base + 2);
+      idx[3] = static_cast<ImDrawIdx>(base);
+      idx[4] = static_cast<ImDrawIdx>(base + 2);
+      idx[5] = static_cast<ImDrawIdx>(base + 3);
+    }
+    draw_list._VtxWritePtr += count * 4;
+    draw_list._IdxWritePtr += count * 6;
+    draw_list._VtxCurrentIdx += count * 4;
+    src += count * 4;
+    quads -= count;
+  }
+}
+
+} // namespace detail
+
+// Plots getter(0) ... getter(count - 1), with getter(idx) returning an
+// ImPlotPoint, as a line item. The segments are split into chunks which the
+// pool transforms to pixels (see transform_kernels.hpp) and tessellates, the
+// vertex blocks are then appended to the plot's draw list in order. The
+// geometry is the same as ImPlot's. Check can_plot_line_parallel() first.
+// getter is called from several threads at once.
+template <typename Getter>
+void plot_line_parallel(WorkerPool& pool, const char* label_id,
+                        const Getter& getter, int count) {
+  if (!ImPlot::BeginItem(label_id, ImPlotCol_Line)) {
+    return;
+  }
+  const ImPlotNextItemData& s = ImPlot::GetItemData();
+  if (count > 1 && s.RenderLine) {
+    ImDrawList& draw_list = *ImPlot::GetPlotDrawList();
+    const ImU32 col = ImGui::GetColorU32(s.Colors[ImPlotCol_Line]);
+    const float weight = s.LineWeight;
+    const ImVec2 uv = draw_list._Data->TexUvWhitePixel;
+    const ImRect cull_rect = GImPlot->BB_Plot;
+    const PlotTransform transform;
+
+    // Small enough chunks to balance uneven culling between the threads
+    constexpr int min_segments = 1 << 14;
+    const int segments = count - 1;
+    const int chunks = std::max(
+        1, std::min(4 * pool.size(), segments / min_segments));
+    thread_local std::vector<std::vector<ImDrawVert>> blocks;
+    if (static_cast<int>(blocks.size()) < chunks) {
+      blocks.resize(chunks);
+    }
+    // Lambdas do not capture thread_local variables, the workers would see
+    // their own (empty) blocks
+    auto& chunk_blocks = blocks;
+    pool.run(chunks, [&](int chunk) {
+      const auto first = static_cast<int>(int64_t{segments} * chunk / chunks);
+      const auto last =
+          static_cast<int>(int64_t{segments} * (chunk + 1) / chunks);
+      auto& block = chunk_blocks[chunk];
+      block.clear();
+      // Points first ... last, transformed in batches. The first one of a
+      // batch is the last one of the previous batch.
+      constexpr int batch = 512;
+      double xs[batch];
+      double ys[batch];
+      float px[batch];
+      float py[batch];
+      for (int begin = first; begin < last; begin += batch - 1) {
+        const int n = std::min(batch, last + 1 - begin);
+        for (int i = 0; i < n; ++i) {
+          const ImPlotPoint point = getter(begin + i);
+          xs[i] = point.x;
+          ys[i] = point.y;
+        }
+        transform.apply(xs, ys, n, px, py);
+        ImVec2 p1(px[0], py[0]);
+        for (int i = 1; i < n; ++i) {
+          const ImVec2 p2(px[i], py[i]);
+          if (cull_rect.Overlaps(ImRect(ImMin(p1, p2), ImMax(p1, p2)))) {
+            detail::add_segment(block, p1, p2, weight, col, uv);
+          }
+          p1 = p2;
+        }
+      }
+    });
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+      detail::append_quads(draw_list, blocks[chunk]);
+    }
+  }
+  ImPlot::EndItem();
+}
+
+#endif
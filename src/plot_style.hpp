@@ -0,0 +1,84 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_STYLE_HPP
+#define _PLOT_STYLE_HPP
+
+#include <implot.h>
+
+// Style of a single plot item. Plot functions take it as their style
+// argument and hand it to ImPlot's SetNext*Style() right before the item, so
+// one Python call styles an item instead of a push, plot and pop. ImPlot
+// drops the next item style after the item itself, which leaves nothing to
+// restore. IMPLOT_AUTO and IMPLOT_AUTO_COL keep the current style.
+struct ItemStyle {
+  ImVec4 lineColor = IMPLOT_AUTO_COL;
+  float lineWeight = IMPLOT_AUTO;
+  ImVec4 fillColor = IMPLOT_AUTO_COL;
+  float fillAlpha = IMPLOT_AUTO;
+  ImPlotMarker marker = IMPLOT_AUTO;
+  float markerSize = IMPLOT_AUTO;
+  ImVec4 markerFill = IMPLOT_AUTO_COL;
+  float markerWeight = IMPLOT_AUTO;
+  ImVec4 markerOutline = IMPLOT_AUTO_COL;
+  ImVec4 errorBarColor = IMPLOT_AUTO_COL;
+  float errorBarSize = IMPLOT_AUTO;
+  float errorBarWeight = IMPLOT_AUTO;
+
+  void apply() const {
+    ImPlot::SetNextLineStyle(this->lineColor, this->lineWeight);
+    ImPlot::SetNextFillStyle(this->fillColor, this->fillAlpha);
+    ImPlot::SetNextMarkerStyle(this->marker, this->markerSize,
+                               this->markerFill, this->markerWeight,
+                               this->markerOutline);
+    ImPlot::SetNextErrorBarStyle(this->errorBarColor, this->errorBarSize,
+                                 this->errorBarWeight);
+  }
+};
+
+// Styles the next item if a style was given.
+inline void apply_style(const ItemStyle* style) {
+  if (style != nullptr) {
+    style->apply();
+  }
+}
+
+#endif
@@ -0,0 +1,88 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _PLOT_TRANSFORM_HPP
+#define _PLOT_TRANSFORM_HPP
+
+#include <implot.h>
+#include <implot_internal.h>
+
+#include "transform_kernels.hpp"
+
+// Plot to pixel mapping of the current plot and y axis, the same arithmetic as
+// ImPlot's transformers. The state is copied out of the ImPlot context, so the
+// transform can be used from worker threads.
+class PlotTransform {
+public:
+  PlotTransform() {
+    const ImPlotContext& gp = *GImPlot;
+    const ImPlotPlot& plot = *gp.CurrentPlot;
+    const int y_axis = plot.CurrentYAxis;
+    const ImPlotAxis& axis_x = plot.XAxis;
+    const ImPlotAxis& axis_y = plot.YAxis[y_axis];
+    this->x = AxisTransform{gp.PixelRange[y_axis].Min.x,
+                            gp.Mx,
+                            axis_x.Range.Min,
+                            axis_x.Range.Max,
+                            gp.LogDenX,
+                            ImHasFlag(axis_x.Flags, ImPlotAxisFlags_LogScale)};
+    this->y = AxisTransform{gp.PixelRange[y_axis].Min.y,
+                            gp.My[y_axis],
+                            axis_y.Range.Min,
+                            axis_y.Range.Max,
+                            gp.LogDenY[y_axis],
+                            ImHasFlag(axis_y.Flags, ImPlotAxisFlags_LogScale)};
+  }
+
+  // Transforms count points to pixel coordinates, with the vectorized kernels
+  // of the CPU.
+  void apply(const double* xs, const double* ys, int count, float* px,
+             float* py) const {
+    transform_axis(this->x, xs, count, px);
+    transform_axis(this->y, ys, count, py);
+  }
+
+private:
+  AxisTransform x;
+  AxisTransform y;
+};
+
+#endif
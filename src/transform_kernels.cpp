@@ -0,0 +1,136 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include "transform_kernels.hpp"
+
+#include <atomic>
+#include <cmath>
+
+#if defined(TRANSFORM_KERNELS_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+void transform_axis_scalar(const AxisTransform& axis, const double* values,
+                           int count, float* out) {
+  for (int i = 0; i < count; ++i) {
+    double value = values[i];
+    if (axis.log) {
+      const double t = std::log10(value / axis.min) / axis.logDen;
+      value = axis.min + (axis.max - axis.min) * static_cast<float>(t);
+    }
+    out[i] = static_cast<float>(axis.pixel + axis.scale * (value - axis.min));
+  }
+}
+
+static SimdLevel detect_simd_level() {
+#if defined(TRANSFORM_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return SimdLevel::AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return SimdLevel::AVX2;
+  }
+  return SimdLevel::SSE2;
+#elif defined(TRANSFORM_KERNELS_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuidex(info, 1, 0);
+  const bool os_xsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  // Register state the OS saves: SSE and AVX, plus the AVX-512 registers
+  const unsigned long long xcr0 = os_xsave ? _xgetbv(0) : 0;
+  __cpuidex(info, 0, 0);
+  if (info[0] < 7) {
+    return SimdLevel::SSE2;
+  }
+  __cpuidex(info, 7, 0);
+  const bool avx2 = (info[1] & (1 << 5)) != 0;
+  const bool avx512f = (info[1] & (1 << 16)) != 0;
+  if (avx512f && (xcr0 & 0xE6) == 0xE6) {
+    return SimdLevel::AVX512;
+  }
+  if (avx && avx2 && (xcr0 & 0x6) == 0x6) {
+    return SimdLevel::AVX2;
+  }
+  return SimdLevel::SSE2;
+#else
+  return SimdLevel::Scalar;
+#endif
+}
+
+SimdLevel supported_simd_level() {
+  static const SimdLevel supported = detect_simd_level();
+  return supported;
+}
+
+static std::atomic<SimdLevel>& selected_level() {
+  static std::atomic<SimdLevel> level{supported_simd_level()};
+  return level;
+}
+
+SimdLevel simd_level() { return selected_level().load(); }
+
+void set_simd_level(SimdLevel level) {
+  if (level > supported_simd_level()) {
+    level = supported_simd_level();
+  }
+  selected_level().store(level);
+}
+
+void transform_axis(const AxisTransform& axis, const double* values,
+                    int count, float* out) {
+  switch (simd_level()) {
+#ifdef TRANSFORM_KERNELS_X86
+  case SimdLevel::AVX512:
+    transform_axis_avx512(axis, values, count, out);
+    return;
+  case SimdLevel::AVX2:
+    transform_axis_avx2(axis, values, count, out);
+    return;
+  case SimdLevel::SSE2:
+    transform_axis_sse2(axis, values, count, out);
+    return;
+#endif
+  default:
+    transform_axis_scalar(axis, values, count, out);
+  }
+}
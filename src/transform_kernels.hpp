@@ -0,0 +1,93 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _TRANSFORM_KERNELS_HPP
+#define _TRANSFORM_KERNELS_HPP
+
+// Plot to pixel transform of one axis over contiguous values. There are SSE2,
+// AVX2 and AVX-512 kernels, each in a translation unit of its own compiled
+// for that instruction set, picked at runtime by what the CPU supports.
+// Nothing here depends on ImPlot, the kernels are also built into the
+// transform benchmark.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define TRANSFORM_KERNELS_X86
+#endif
+
+// The mapping of one axis, the same arithmetic as ImPlot's transformers:
+// on log axes a value is first mapped to
+//   min + (max - min) * (float)(log10(value / min) / logDen)
+// and every value then to pixel + scale * (value - min).
+struct AxisTransform {
+  double pixel;
+  double scale;
+  double min;
+  double max;
+  double logDen;
+  bool log;
+};
+
+enum class SimdLevel { Scalar = 0, SSE2, AVX2, AVX512 };
+
+// Transforms count values to pixels with the selected kernel.
+void transform_axis(const AxisTransform& axis, const double* values,
+                    int count, float* out);
+
+// Best level the CPU (and OS) supports.
+SimdLevel supported_simd_level();
+// Level used by transform_axis(), the supported one unless lowered.
+SimdLevel simd_level();
+// Selects a kernel, clamped to the supported level. Used for benchmarks.
+void set_simd_level(SimdLevel level);
+
+// The kernels, call through transform_axis().
+void transform_axis_scalar(const AxisTransform& axis, const double* values,
+                           int count, float* out);
+#ifdef TRANSFORM_KERNELS_X86
+void transform_axis_sse2(const AxisTransform& axis, const double* values,
+                         int count, float* out);
+void transform_axis_avx2(const AxisTransform& axis, const double* values,
+                         int count, float* out);
+void transform_axis_avx512(const AxisTransform& axis, const double* values,
+                           int count, float* out);
+#endif
+
+#endif
@@ -0,0 +1,99 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include "transform_kernels.hpp"
+
+#ifdef TRANSFORM_KERNELS_X86
+
+#include <cfloat>
+#include <immintrin.h>
+
+namespace {
+
+struct Ops {
+  using D = __m512d;
+  static constexpr int width = 8;
+  // The unmasked intrinsics pass an undefined source to their masked forms,
+  // which GCC reports as maybe uninitialized. The zeroing forms with all
+  // lanes set are the same instructions.
+  static constexpr __mmask8 all = 0xFF;
+
+  static D set1(double value) { return _mm512_set1_pd(value); }
+  static D load(const double* values) { return _mm512_loadu_pd(values); }
+  static void store(float* out, D x) {
+    _mm256_storeu_ps(out, _mm512_maskz_cvtpd_ps(all, x));
+  }
+  static D add(D a, D b) { return _mm512_add_pd(a, b); }
+  static D sub(D a, D b) { return _mm512_sub_pd(a, b); }
+  static D mul(D a, D b) { return _mm512_mul_pd(a, b); }
+  static D div(D a, D b) { return _mm512_div_pd(a, b); }
+  // 1.0 where a > b, else 0.0
+  static D gt_ones(D a, D b) {
+    return _mm512_maskz_mov_pd(_mm512_cmp_pd_mask(a, b, _CMP_GT_OQ),
+                               _mm512_set1_pd(1.0));
+  }
+  static bool all_normal(D x) {
+    const __mmask8 normal =
+        _mm512_cmp_pd_mask(x, _mm512_set1_pd(DBL_MIN), _CMP_GE_OQ) &
+        _mm512_cmp_pd_mask(x, _mm512_set1_pd(DBL_MAX), _CMP_LE_OQ);
+    return normal == 0xFF;
+  }
+  static D round_to_float(D x) {
+    return _mm512_maskz_cvtps_pd(all, _mm512_maskz_cvtpd_ps(all, x));
+  }
+  // AVX-512 extracts exponent and mantissa directly
+  static D exponent(D x) { return _mm512_maskz_getexp_pd(all, x); }
+  static D mantissa(D x) {
+    return _mm512_maskz_getmant_pd(all, x, _MM_MANT_NORM_1_2,
+                                   _MM_MANT_SIGN_zero);
+  }
+};
+
+} // namespace
+
+#include "transform_kernels_simd.hpp"
+
+void transform_axis_avx512(const AxisTransform& axis, const double* values,
+                           int count, float* out) {
+  simd_transform_axis<Ops>(axis, values, count, out);
+}
+
+#endif
@@ -0,0 +1,122 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+// Included by the instruction set specific translation units only. Each one
+// defines an Ops struct of vector operations before including this file, so
+// everything here has internal linkage and is compiled for that instruction
+// set. Standard library functions are avoided on purpose, an inline function
+// compiled with AVX could otherwise be picked by the linker for all callers.
+
+#ifndef _TRANSFORM_KERNELS_SIMD_HPP
+#define _TRANSFORM_KERNELS_SIMD_HPP
+
+#include "transform_kernels.hpp"
+
+namespace {
+
+// log2 of positive, finite, normal values. The exponent comes from the bits,
+// the log of the mantissa m in [sqrt(1/2), sqrt(2)) from the series
+// log(m) = 2 atanh(s) = 2 (s + s^3 / 3 + s^5 / 5 + ...), s = (m - 1) / (m + 1).
+// With |s| < 0.1716 the terms up to s^17 are exact to double precision.
+template <typename V> typename V::D simd_log2(typename V::D x) {
+  using D = typename V::D;
+  const D one = V::set1(1.0);
+  D e = V::exponent(x);
+  D m = V::mantissa(x);
+  const D above = V::gt_ones(m, V::set1(1.4142135623730951));
+  e = V::add(e, above);
+  m = V::mul(m, V::sub(one, V::mul(above, V::set1(0.5))));
+  const D s = V::div(V::sub(m, one), V::add(m, one));
+  const D z = V::mul(s, s);
+  static const double coeffs[] = {1.0 / 15, 1.0 / 13, 1.0 / 11, 1.0 / 9,
+                                   1.0 / 7,  1.0 / 5,  1.0 / 3,  1.0};
+  D p = V::set1(1.0 / 17);
+  for (const double coeff : coeffs) {
+    p = V::add(V::mul(p, z), V::set1(coeff));
+  }
+  // 2 / ln(2)
+  return V::add(e, V::mul(V::mul(s, p), V::set1(2.8853900817779268)));
+}
+
+template <typename V, bool Log>
+void simd_transform(const AxisTransform& axis, const double* values,
+                    int count, float* out) {
+  using D = typename V::D;
+  const D pixel = V::set1(axis.pixel);
+  const D scale = V::set1(axis.scale);
+  const D min = V::set1(axis.min);
+  const D range = V::set1(axis.max - axis.min);
+  // log10(x) / logDen as log2(x) * log10(2) / logDen
+  const D log_scale = V::set1(0.30102999566398120 / axis.logDen);
+  int i = 0;
+  for (; i + V::width <= count; i += V::width) {
+    D v = V::load(values + i);
+    if (Log) {
+      const D ratio = V::div(v, min);
+      // Zero, negative, denormal, infinite and NaN ratios take the scalar
+      // path, which gives the same results as ImPlot for them
+      if (!V::all_normal(ratio)) {
+        transform_axis_scalar(axis, values + i, V::width, out + i);
+        continue;
+      }
+      const D t = V::round_to_float(V::mul(simd_log2<V>(ratio), log_scale));
+      v = V::add(min, V::mul(range, t));
+    }
+    V::store(out + i, V::add(pixel, V::mul(scale, V::sub(v, min))));
+  }
+  if (i < count) {
+    transform_axis_scalar(axis, values + i, count - i, out + i);
+  }
+}
+
+template <typename V>
+void simd_transform_axis(const AxisTransform& axis, const double* values,
+                         int count, float* out) {
+  if (axis.log) {
+    simd_transform<V, true>(axis, values, count, out);
+  } else {
+    simd_transform<V, false>(axis, values, count, out);
+  }
+}
+
+} // namespace
+
+#endif
@@ -0,0 +1,100 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#include "transform_kernels.hpp"
+
+#ifdef TRANSFORM_KERNELS_X86
+
+#include <cfloat>
+#include <emmintrin.h>
+
+namespace {
+
+struct Ops {
+  using D = __m128d;
+  static constexpr int width = 2;
+
+  static D set1(double value) { return _mm_set1_pd(value); }
+  static D load(const double* values) { return _mm_loadu_pd(values); }
+  static void store(float* out, D x) {
+    _mm_storel_pi(reinterpret_cast<__m64*>(out), _mm_cvtpd_ps(x));
+  }
+  static D add(D a, D b) { return _mm_add_pd(a, b); }
+  static D sub(D a, D b) { return _mm_sub_pd(a, b); }
+  static D mul(D a, D b) { return _mm_mul_pd(a, b); }
+  static D div(D a, D b) { return _mm_div_pd(a, b); }
+  // 1.0 where a > b, else 0.0
+  static D gt_ones(D a, D b) {
+    return _mm_and_pd(_mm_cmpgt_pd(a, b), _mm_set1_pd(1.0));
+  }
+  static bool all_normal(D x) {
+    const D normal = _mm_and_pd(_mm_cmpge_pd(x, _mm_set1_pd(DBL_MIN)),
+                                _mm_cmple_pd(x, _mm_set1_pd(DBL_MAX)));
+    return _mm_movemask_pd(normal) == 0x3;
+  }
+  static D round_to_float(D x) { return _mm_cvtps_pd(_mm_cvtpd_ps(x)); }
+  // Unbiased exponent of positive values. The biased exponent is put into
+  // the mantissa of 2^52 to convert it without 64 bit integer conversions.
+  static D exponent(D x) {
+    const __m128i biased = _mm_srli_epi64(_mm_castpd_si128(x), 52);
+    const D shifted = _mm_castsi128_pd(
+        _mm_or_si128(biased, _mm_set1_epi64x(0x4330000000000000)));
+    return _mm_sub_pd(shifted, _mm_set1_pd(4503599627370496.0 + 1023.0));
+  }
+  // Mantissa of positive values in [1, 2)
+  static D mantissa(D x) {
+    const __m128i bits =
+        _mm_and_si128(_mm_castpd_si128(x), _mm_set1_epi64x(0x000FFFFFFFFFFFFF));
+    return _mm_castsi128_pd(
+        _mm_or_si128(bits, _mm_set1_epi64x(0x3FF0000000000000)));
+  }
+};
+
+} // namespace
+
+#include "transform_kernels_simd.hpp"
+
+void transform_axis_sse2(const AxisTransform& axis, const double* values,
+                         int count, float* out) {
+  simd_transform_axis<Ops>(axis, values, count, out);
+}
+
+#endif
@@ -0,0 +1,815 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _VALUE_GETTER_HPP
+#define _VALUE_GETTER_HPP
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <implot.h>
+#include <numeric>
+#include <string>
+#include <pybind11/pybind11.h>
+#include <tuple>
+#include <vector>
+
+#include "plot_kernels.hpp"
+
+namespace py = pybind11;
+
+// Element types understood by ValueGetter.
+enum class ValueType {
+  Bool,
+  Float16,
+  Float,
+  Double,
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Int64,
+  UInt64
+};
+
+template <typename T> struct type_tag { using type = T; };
+
+// numpy bool, read as a byte so that any non-zero value is true.
+struct bool8 {
+  uint8_t bits;
+
+  operator double() const { return bits != 0 ? 1.0 : 0.0; }
+};
+
+// numpy float16 (IEEE 754 half precision).
+struct float16 {
+  uint16_t bits;
+
+  operator double() const {
+    const int exponent = (bits >> 10) & 0x1f;
+    const int mantissa = bits & 0x3ff;
+    double value;
+    if (exponent == 0) {
+      value = std::ldexp(mantissa, -24);
+    } else if (exponent == 0x1f) {
+      value = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                            : std::numeric_limits<double>::quiet_NaN();
+    } else {
+      value = std::ldexp(mantissa + 0x400, exponent - 25);
+    }
+    return (bits & 0x8000) != 0 ? -value : value;
+  }
+};
+
+// Whether ImPlot's typed API was instantiated with T.
+template <typename T>
+constexpr bool is_implot_value =
+    !std::is_same<T, bool8>::value && !std::is_same<T, float16>::value;
+
+// ImPlot is instantiated with ImS64/ImU64 which are not necessarily the same
+// types as int64_t/uint64_t (long long vs. long).
+template <typename T>
+using implot_type = std::conditional_t<
+    std::is_same<T, int64_t>::value, ImS64,
+    std::conditional_t<std::is_same<T, uint64_t>::value, ImU64, T>>;
+static_assert(sizeof(ImS64) == sizeof(int64_t) &&
+              sizeof(ImU64) == sizeof(uint64_t));
+
+// Calls fn(type_tag<T>{}) with the C++ type T corresponding to value_type.
+template <typename Fn>
+decltype(auto) dispatch_value_type(ValueType value_type, Fn&& fn) {
+#define VG_EMIT_CASE(__enum__, __type__)                                       \
+  case ValueType::__enum__:                                                    \
+    return fn(type_tag<__type__>{});
+
+  switch (value_type) {
+    VG_EMIT_CASE(Bool, bool8);
+    VG_EMIT_CASE(Float16, float16);
+    VG_EMIT_CASE(Float, float);
+    VG_EMIT_CASE(Double, double);
+    VG_EMIT_CASE(Int8, int8_t);
+    VG_EMIT_CASE(UInt8, uint8_t);
+    VG_EMIT_CASE(Int16, int16_t);
+    VG_EMIT_CASE(UInt16, uint16_t);
+    VG_EMIT_CASE(Int32, int32_t);
+    VG_EMIT_CASE(UInt32, uint32_t);
+    VG_EMIT_CASE(Int64, int64_t);
+    VG_EMIT_CASE(UInt64, uint64_t);
+  }
+#undef VG_EMIT_CASE
+  throw std::logic_error("Unhandled ValueType!");
+}
+
+// Calls fn(values) with a typed kernels accessor for strided values of the
+// given type, swapping bytes if they are not in native order.
+template <typename Fn>
+void visit_values(const char* ptr, py::ssize_t stride, ValueType value_type,
+                  bool swapped, Fn&& fn) {
+  dispatch_value_type(value_type, [&](auto tag) {
+    using T = typename decltype(tag)::type;
+    if (swapped) {
+      fn(kernels::SwappedArray<T>{ptr, stride});
+    } else {
+      fn(kernels::StridedArray<T>{ptr, stride});
+    }
+  });
+}
+
+// Reads a single value of type T, for getters that can not be specialized on
+// every type combination.
+typedef double value_loader(const char* ptr);
+template <typename T, bool Swap> double load_value(const char* ptr) {
+  T value;
+  std::memcpy(&value, ptr, sizeof(T));
+  if constexpr (Swap) {
+    value = kernels::byte_swap(value);
+  }
+  return static_cast<double>(value);
+}
+
+// Converts numpy datetime64 (or timedelta64) values to ImPlot's UNIX seconds.
+// An integer origin of whole seconds is subtracted before converting to
+// double, so nanosecond time stamps are rounded only once.
+struct TimeScale {
+  // 0 if the values are not time stamps
+  double secondsPerUnit = 0.0;
+  // One unit is unitSeconds / unitFraction seconds, reduced
+  int64_t unitSeconds = 0;
+  int64_t unitFraction = 1;
+  int64_t origin = 0;
+  double originSeconds = 0.0;
+
+  [[nodiscard]] bool is_time() const { return this->secondsPerUnit != 0.0; }
+
+  void set_unit(int64_t seconds, int64_t fraction) {
+    const auto divisor = std::gcd(seconds, fraction);
+    this->unitSeconds = seconds / divisor;
+    this->unitFraction = fraction / divisor;
+    this->secondsPerUnit = static_cast<double>(this->unitSeconds) /
+                           static_cast<double>(this->unitFraction);
+  }
+
+  // Rounds value down to a multiple of unitFraction units, which is a whole
+  // number of seconds.
+  void set_origin(int64_t value) {
+    // Floor division, time stamps before 1970 are negative
+    auto periods = value / this->unitFraction;
+    if (value % this->unitFraction < 0) {
+      --periods;
+    }
+    this->origin = periods * this->unitFraction;
+    this->originSeconds =
+        static_cast<double>(periods) * static_cast<double>(this->unitSeconds);
+  }
+
+  [[nodiscard]] double to_seconds(int64_t value) const {
+    if (value == std::numeric_limits<int64_t>::min()) {
+      // NaT
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+    // Wrapping subtraction, the difference is small for any sensible origin
+    const auto delta = static_cast<int64_t>(
+        static_cast<uint64_t>(value) - static_cast<uint64_t>(this->origin));
+    return this->originSeconds +
+           static_cast<double>(delta) * this->secondsPerUnit;
+  }
+
+  // numpy does not export datetime64 and timedelta64 arrays through the
+  // buffer protocol. Only if the request fails, such arrays are requested as
+  // int64 and their unit is kept.
+  static py::buffer_info request(const py::buffer& buf, TimeScale& time) {
+    try {
+      return buf.request();
+    } catch (py::error_already_set&) {
+      if (!py::hasattr(buf, "dtype")) {
+        throw;
+      }
+      const auto dtype = buf.attr("dtype");
+      const auto kind = dtype.attr("kind").cast<std::string>();
+      if (kind != "M" && kind != "m") {
+        throw;
+      }
+      return request_time(buf, dtype, time);
+    }
+  }
+
+private:
+  static py::buffer_info request_time(const py::buffer& buf,
+                                      const py::object& dtype,
+                                      TimeScale& time) {
+    const auto numpy = py::module::import("numpy");
+    const auto unit_data = numpy.attr("datetime_data")(dtype);
+    const auto unit = unit_data[py::int_(0)].cast<std::string>();
+    const auto count = unit_data[py::int_(1)].cast<int64_t>();
+    // Seconds and fraction of a second per unit
+    static const std::tuple<const char*, int64_t, int64_t> units[] = {
+        {"W", 604800, 1},
+        {"D", 86400, 1},
+        {"h", 3600, 1},
+        {"m", 60, 1},
+        {"s", 1, 1},
+        {"ms", 1, 1000},
+        {"us", 1, 1000000},
+        {"ns", 1, 1000000000},
+        {"ps", 1, 1000000000000},
+        {"fs", 1, 1000000000000000},
+        {"as", 1, 1000000000000000000}};
+    for (const auto& [name, seconds, fraction] : units) {
+      if (unit == name) {
+        if (count <= 0 ||
+            count > std::numeric_limits<int64_t>::max() / seconds) {
+          throw std::runtime_error("Unsupported time unit multiple!");
+        }
+        time.set_unit(seconds * count, fraction);
+        // Keeps the byte order, e.g. '>M8[ns]' is viewed as '>i8'
+        const auto int64 = numpy.attr("dtype")("i8").attr("newbyteorder")(
+            dtype.attr("byteorder"));
+        return py::buffer(buf.attr("view")(int64)).request();
+      }
+    }
+    // Years and months have no fixed length
+    throw std::runtime_error("Unsupported time unit '" + unit + "'!");
+  }
+};
+
+// RAII Helper to pin buffers and template expand correct callback getter func.
+// Buffers do not need to be contiguous, strides are honored (e.g. column views
+// of 2D arrays or fields of structured arrays). The element types are resolved
+// once on construction, so keeping an instance around (see Series) makes
+// plotting a matter of pointer and count.
+struct ValueGetter {
+public:
+  explicit ValueGetter(const py::buffer& bufY)
+      : hasX(false), infoY(TimeScale::request(bufY, timeY)) {
+    if (this->infoY.ndim != 1) {
+      throw std::runtime_error(error_dim);
+    }
+    check_size(this->infoY);
+    this->strideY = this->infoY.strides.at(0);
+    this->typeY = resolve_value_type(this->infoY);
+    this->swappedY = is_byte_swapped(this->infoY);
+    init_time_origin(this->infoY, this->swappedY, this->timeY);
+    this->getter = resolve_getter_func();
+    reset_range();
+  }
+  explicit ValueGetter(const py::buffer& bufX, const py::buffer& bufY)
+      : hasX(true), infoX(TimeScale::request(bufX, timeX)),
+        infoY(TimeScale::request(bufY, timeY)) {
+    if (this->infoX.ndim != 1 || this->infoY.ndim != 1 ||
+        this->infoX.shape.at(0) != this->infoY.shape.at(0)) {
+      throw std::runtime_error(error_dim);
+    }
+    check_size(this->infoY);
+    this->strideX = this->infoX.strides.at(0);
+    this->strideY = this->infoY.strides.at(0);
+    this->typeX = resolve_value_type(this->infoX);
+    this->typeY = resolve_value_type(this->infoY);
+    this->swappedX = is_byte_swapped(this->infoX);
+    this->swappedY = is_byte_swapped(this->infoY);
+    init_time_origin(this->infoX, this->swappedX, this->timeX);
+    init_time_origin(this->infoY, this->swappedY, this->timeY);
+    this->getter = resolve_getter_func();
+    reset_range();
+  }
+
+  typedef ImPlotPoint getter_func(void* data, int idx);
+  [[nodiscard]] getter_func* get_getter_func() const { return getter; }
+
+  // Calls fn_y(const T* ys, int count, int stride) or, if there are x values,
+  // fn_xy(const T* xs, const T* ys, int count, int stride) if the buffers can
+  // be passed to ImPlot's typed API directly. That requires a type ImPlot was
+  // instantiated with (anything but bool and float16) in native byte order,
+  // the same type for both buffers and a shared positive stride (ImPlot takes
+  // a single stride for both). Returns false if the getter has to be used
+  // instead.
+  template <typename FnY, typename FnXY>
+  bool visit_typed(FnY&& fn_y, FnXY&& fn_xy) const {
+    if (!has_implot_type(this->typeY, this->swappedY) ||
+        !is_implot_stride(this->strideY) || this->timeY.is_time() ||
+        (hasX && (this->typeX != this->typeY || this->swappedX ||
+                  this->timeX.is_time() || this->strideX != this->strideY))) {
+      return false;
+    }
+    dispatch_value_type(this->typeY, [&](auto tag) {
+      using T = implot_type<typename decltype(tag)::type>;
+      if constexpr (is_implot_value<T>) {
+        const auto stride = static_cast<int>(this->strideY);
+        if (hasX) {
+          fn_xy(reinterpret_cast<const T*>(this->dataX),
+                reinterpret_cast<const T*>(this->dataY), count(), stride);
+        } else {
+          fn_y(reinterpret_cast<const T*>(this->dataY), count(), stride);
+        }
+      }
+    });
+    return true;
+  }
+
+  // Calls fn(ys) with a typed kernels accessor for the y values.
+  template <typename Fn> void visit_y(Fn&& fn) const {
+    if (this->timeY.is_time()) {
+      fn(kernels::make_func_array([this](std::ptrdiff_t idx) {
+        return load_y(static_cast<int>(idx));
+      }));
+      return;
+    }
+    dispatch_value_type(this->typeY, [&](auto tag) {
+      using T = typename decltype(tag)::type;
+      if (!this->swappedY &&
+          this->strideY == static_cast<py::ssize_t>(sizeof(T))) {
+        fn(kernels::PackedArray<T>{reinterpret_cast<const T*>(this->dataY)});
+      } else if (!this->swappedY) {
+        fn(kernels::StridedArray<T>{this->dataY, this->strideY});
+      } else {
+        fn(kernels::SwappedArray<T>{this->dataY, this->strideY});
+      }
+    });
+  }
+
+  // Calls fn(xs) with a kernels accessor for the x values, which are the
+  // indices if there are none.
+  template <typename Fn> void visit_x(Fn&& fn) const {
+    if (!hasX) {
+      fn(kernels::IndexArray{this->first});
+    } else if (this->timeX.is_time()) {
+      fn(kernels::make_func_array([this](std::ptrdiff_t idx) {
+        return load_x(static_cast<int>(idx));
+      }));
+    } else {
+      visit_values(this->dataX, this->strideX, this->typeX, this->swappedX,
+                   std::forward<Fn>(fn));
+    }
+  }
+
+  [[nodiscard]] bool has_x() const { return hasX; }
+
+  // Number of values in the current range.
+  [[nodiscard]] int count() const { return this->last - this->first; };
+
+  // Number of values in the buffers.
+  [[nodiscard]] int size() const {
+    auto size = this->infoY.shape.at(0);
+    assert(size >= 0);
+    assert(size <= std::numeric_limits<int>::max());
+    return static_cast<int>(size);
+  }
+
+  // Restricts the getter, typed and kernel access to the values [first,
+  // last). Indices are relative to first from then on, but y-only values
+  // keep their original index as x.
+  void set_range(int first, int last) {
+    assert(0 <= first && first <= last && last <= size());
+    this->first = first;
+    this->last = last;
+    if (hasX) {
+      this->dataX =
+          static_cast<const char*>(this->infoX.ptr) + first * this->strideX;
+    }
+    this->dataY =
+        static_cast<const char*>(this->infoY.ptr) + first * this->strideY;
+  }
+  void reset_range() { set_range(0, size()); }
+  [[nodiscard]] int range_first() const { return this->first; }
+
+  // Returns whether the x values are sorted ascending. The result is cached
+  // until invalidate() is called.
+  bool is_x_sorted() {
+    if (!hasX) {
+      return true;
+    }
+    if (this->sortedX < 0) {
+      const int range_first = this->first;
+      const int range_last = this->last;
+      reset_range();
+      visit_x([this](const auto& xs) {
+        this->sortedX = kernels::is_sorted(xs, count()) ? 1 : 0;
+      });
+      set_range(range_first, range_last);
+    }
+    return this->sortedX > 0;
+  }
+
+  // Whether the x values are known to be sorted without checking them.
+  [[nodiscard]] bool is_x_sorted_cached() const {
+    return !hasX || this->sortedX > 0;
+  }
+
+  // Whether the x values are known not to be sorted.
+  [[nodiscard]] bool is_x_unsorted_cached() const {
+    return hasX && this->sortedX == 0;
+  }
+
+  // Declares whether the x values are sorted, skipping the check.
+  void set_x_sorted(bool sorted) { this->sortedX = sorted ? 1 : 0; }
+
+  // Extents of all values (regardless of the current range), ignoring NaN.
+  // The result is cached until invalidate() is called.
+  [[nodiscard]] const ImPlotLimits& extents() {
+    if (this->hasExtents) {
+      return this->cachedExtents;
+    }
+    const int range_first = this->first;
+    const int range_last = this->last;
+    reset_range();
+    const int n = count();
+    auto& limits = this->cachedExtents;
+    visit_x([&](const auto& xs) {
+      if (n > 0 && is_x_sorted_cached() && !std::isnan(xs[0]) &&
+          !std::isnan(xs[n - 1])) {
+        limits.X = ImPlotRange(xs[0], xs[n - 1]);
+      } else {
+        const auto [lo, hi] = kernels::min_max(xs, 0, n);
+        limits.X = ImPlotRange(lo, hi);
+      }
+    });
+    visit_y([&](const auto& ys) {
+      const auto [lo, hi] = kernels::min_max(ys, 0, n);
+      limits.Y = ImPlotRange(lo, hi);
+    });
+    set_range(range_first, range_last);
+    this->hasExtents = true;
+    return limits;
+  }
+
+  // Drops cached properties of the data after it was modified in place.
+  void invalidate() {
+    this->sortedX = -1;
+    this->hasExtents = false;
+  }
+
+protected:
+  static const constexpr char* error_dim = "Incompatible buffer dimension!";
+  static const constexpr char* error_size =
+      "Too many values, use SeriesPyramid for more than 2^31 - 1!";
+  static const constexpr char* error_type =
+      "Incompatible format: expected array of bool, float16, float, double "
+      "or unsigned/signed int 8, 16, 32 or 64!";
+
+  // ImPlot counts values with int.
+  static void check_size(const py::buffer_info& info) {
+    if (info.shape.at(0) > std::numeric_limits<int>::max()) {
+      throw std::runtime_error(error_size);
+    }
+  }
+
+public:
+  // ImPlot takes strides as positive int byte offsets.
+  static bool is_implot_stride(py::ssize_t stride) {
+    return stride > 0 && stride <= std::numeric_limits<int>::max();
+  }
+
+  // Whether ImPlot's typed API can read values of the type directly.
+  static bool has_implot_type(ValueType value_type, bool swapped) {
+    return value_type != ValueType::Bool && value_type != ValueType::Float16 &&
+           !swapped;
+  }
+
+  // Maps the struct module format character (with an optional byte order
+  // prefix) and item size to a ValueType. numpy exports 'l' and 'q' (or 'i'
+  // and 'l' on Windows) for 64 bit integers, so integer sizes are taken from
+  // the item size rather than the character.
+  static ValueType resolve_value_type(const py::buffer_info& info) {
+    const auto& format = info.format;
+    const size_t prefix =
+        !format.empty() && std::strchr("@=<>!", format[0]) != nullptr ? 1 : 0;
+    if (format.size() != prefix + 1) {
+      throw std::runtime_error(error_type);
+    }
+    const char code = format[prefix];
+    switch (code) {
+    case '?':
+      if (info.itemsize == 1) {
+        return ValueType::Bool;
+      }
+      break;
+    case 'e':
+      if (info.itemsize == 2) {
+        return ValueType::Float16;
+      }
+      break;
+    case 'f':
+      if (info.itemsize == 4) {
+        return ValueType::Float;
+      }
+      break;
+    case 'd':
+      if (info.itemsize == 8) {
+        return ValueType::Double;
+      }
+      break;
+    case 'b':
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+    case 'n':
+    case 'B':
+    case 'H':
+    case 'I':
+    case 'L':
+    case 'Q':
+    case 'N': {
+      const bool is_signed = code >= 'a';
+      switch (info.itemsize) {
+      case 1:
+        return is_signed ? ValueType::Int8 : ValueType::UInt8;
+      case 2:
+        return is_signed ? ValueType::Int16 : ValueType::UInt16;
+      case 4:
+        return is_signed ? ValueType::Int32 : ValueType::UInt32;
+      case 8:
+        return is_signed ? ValueType::Int64 : ValueType::UInt64;
+      default:
+        break;
+      }
+      break;
+    }
+    default:
+      break;
+    }
+    throw std::runtime_error(error_type);
+  }
+
+  // Whether the buffer's values are not in native byte order.
+  static bool is_byte_swapped(const py::buffer_info& info) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    const char* foreign_order = "<";
+#else
+    const char* foreign_order = ">!";
+#endif
+    return info.itemsize > 1 && !info.format.empty() &&
+           std::strchr(foreign_order, info.format[0]) != nullptr;
+  }
+
+  // Returns a function reading a single value of the type.
+  static value_loader* resolve_loader(ValueType value_type, bool swapped) {
+    return dispatch_value_type(value_type, [&](auto tag) -> value_loader* {
+      using T = typename decltype(tag)::type;
+      return swapped ? &load_value<T, true> : &load_value<T, false>;
+    });
+  }
+
+protected:
+  // Specialized on the y type and, for the common cases of no x values, x
+  // values of the same type, double or int64, on the x type. Everything else
+  // (including non-native byte order) reads through loader functions, which
+  // keeps the number of instantiations linear in the number of types.
+  template <typename X, typename Y>
+  static ImPlotPoint getValue(void* data, int idx) {
+    const auto* this_ = static_cast<ValueGetter*>(data);
+    double x, y;
+    if constexpr (std::is_void<X>::value) {
+      x = static_cast<double>(this_->first + idx);
+    } else {
+      x = static_cast<double>(*reinterpret_cast<const X*>(
+          this_->dataX + idx * this_->strideX));
+    }
+    y = static_cast<double>(
+        *reinterpret_cast<const Y*>(this_->dataY + idx * this_->strideY));
+    return ImPlotPoint(x, y);
+  }
+
+  static ImPlotPoint getLoadedValue(void* data, int idx) {
+    const auto* this_ = static_cast<ValueGetter*>(data);
+    return ImPlotPoint(
+        this_->hasX ? this_->load_x(idx)
+                    : static_cast<double>(this_->first + idx),
+        this_->load_y(idx));
+  }
+
+  [[nodiscard]] double load_x(int idx) const {
+    const auto* ptr = this->dataX + idx * this->strideX;
+    if (this->timeX.is_time()) {
+      return this->timeX.to_seconds(
+          this->swappedX ? load_int64<true>(ptr) : load_int64<false>(ptr));
+    }
+    return this->loaderX(ptr);
+  }
+
+  [[nodiscard]] double load_y(int idx) const {
+    const auto* ptr = this->dataY + idx * this->strideY;
+    if (this->timeY.is_time()) {
+      return this->timeY.to_seconds(
+          this->swappedY ? load_int64<true>(ptr) : load_int64<false>(ptr));
+    }
+    return this->loaderY(ptr);
+  }
+
+  template <bool Swap> static int64_t load_int64(const char* ptr) {
+    int64_t value;
+    std::memcpy(&value, ptr, sizeof(value));
+    if constexpr (Swap) {
+      value = kernels::byte_swap(value);
+    }
+    return value;
+  }
+
+  // Uses the first valid time stamp as origin.
+  static void init_time_origin(const py::buffer_info& info, bool swapped,
+                               TimeScale& time) {
+    if (!time.is_time()) {
+      return;
+    }
+    const auto* ptr = static_cast<const char*>(info.ptr);
+    for (py::ssize_t i = 0; i < info.shape.at(0); ++i) {
+      const auto value =
+          swapped ? load_int64<true>(ptr + i * info.strides.at(0))
+                  : load_int64<false>(ptr + i * info.strides.at(0));
+      if (value != std::numeric_limits<int64_t>::min()) {
+        time.set_origin(value);
+        return;
+      }
+    }
+  }
+
+  [[nodiscard]] getter_func* resolve_getter_func() {
+    if (this->swappedY || this->timeY.is_time() ||
+        (hasX && (this->swappedX || this->timeX.is_time()))) {
+      if (hasX) {
+        this->loaderX = resolve_loader(this->typeX, this->swappedX);
+      }
+      this->loaderY = resolve_loader(this->typeY, this->swappedY);
+      return &getLoadedValue;
+    }
+    return dispatch_value_type(this->typeY, [&](auto tag_y) -> getter_func* {
+      using Y = typename decltype(tag_y)::type;
+      if (!hasX) {
+        return &getValue<void, Y>;
+      }
+      switch (this->typeX) {
+      case ValueType::Double:
+        return &getValue<double, Y>;
+      case ValueType::Int64:
+        return &getValue<int64_t, Y>;
+      default:
+        if (this->typeX == this->typeY) {
+          return &getValue<Y, Y>;
+        }
+        this->loaderX = resolve_loader(this->typeX, false);
+        this->loaderY = resolve_loader(this->typeY, false);
+        return &getLoadedValue;
+      }
+    });
+  }
+
+private:
+  // Declared first, they are filled in while requesting the buffers
+  TimeScale timeX;
+  TimeScale timeY;
+  const bool hasX;
+  const py::buffer_info infoX;
+  const py::buffer_info infoY;
+  // Byte strides, cached to avoid vector accesses per point
+  py::ssize_t strideX = 0;
+  py::ssize_t strideY = 0;
+  ValueType typeX = ValueType::Double;
+  ValueType typeY = ValueType::Double;
+  bool swappedX = false;
+  bool swappedY = false;
+  value_loader* loaderX = nullptr;
+  value_loader* loaderY = nullptr;
+  getter_func* getter = nullptr;
+  // Start of the current range, see set_range()
+  const char* dataX = nullptr;
+  const char* dataY = nullptr;
+  int first = 0;
+  int last = 0;
+  // -1: unknown, 0: not sorted, 1: sorted
+  int sortedX = -1;
+  bool hasExtents = false;
+  ImPlotLimits cachedExtents;
+};
+
+// Calls fn(values) with a typed kernels accessor for a column of a 1D or 2D
+// buffer of the given type. 1D buffers only have column 0.
+template <typename Fn>
+void visit_column(const py::buffer_info& info, ValueType value_type,
+                  py::ssize_t column, Fn&& fn) {
+  const auto* ptr = static_cast<const char*>(info.ptr);
+  if (info.ndim == 2) {
+    ptr += column * info.strides.at(1);
+  }
+  visit_values(ptr, info.strides.at(0), value_type,
+               ValueGetter::is_byte_swapped(info), std::forward<Fn>(fn));
+}
+
+// Pins N equally long 1D buffers (e.g. xs, ys, neg and pos of error bars) for
+// the plot types ImPlot only has typed overloads for.
+template <size_t N> class BufferGroup {
+public:
+  explicit BufferGroup(const std::array<const py::buffer*, N>& buffers) {
+    for (size_t i = 0; i < N; ++i) {
+      this->infos[i] = buffers[i]->request();
+      if (this->infos[i].ndim != 1 ||
+          this->infos[i].shape.at(0) != this->infos[0].shape.at(0)) {
+        throw std::runtime_error("Incompatible buffer dimension!");
+      }
+      this->types[i] = ValueGetter::resolve_value_type(this->infos[i]);
+    }
+    if (this->infos[0].shape.at(0) > std::numeric_limits<int>::max()) {
+      throw std::runtime_error("Too many values!");
+    }
+  }
+
+  [[nodiscard]] int count() const {
+    return static_cast<int>(this->infos[0].shape.at(0));
+  }
+
+  // Calls fn(std::array<const T*, N> ptrs, int stride). If all buffers share
+  // a type ImPlot was instantiated with and a stride (packed, if required),
+  // they are passed as they are. Otherwise they are converted to packed
+  // doubles first.
+  template <typename Fn> void visit(Fn&& fn, bool require_packed = false) {
+    if (can_pass_typed(require_packed)) {
+      dispatch_value_type(this->types[0], [&](auto tag) {
+        using T = implot_type<typename decltype(tag)::type>;
+        if constexpr (is_implot_value<T>) {
+          std::array<const T*, N> ptrs;
+          for (size_t i = 0; i < N; ++i) {
+            ptrs[i] = static_cast<const T*>(this->infos[i].ptr);
+          }
+          fn(ptrs, static_cast<int>(this->infos[0].strides.at(0)));
+        }
+      });
+      return;
+    }
+    thread_local std::vector<double> scratch;
+    const auto n = this->infos[0].shape.at(0);
+    scratch.resize(N * n);
+    std::array<const double*, N> ptrs;
+    for (size_t i = 0; i < N; ++i) {
+      double* out = scratch.data() + i * n;
+      visit_column(this->infos[i], this->types[i], 0, [&](const auto& values) {
+        for (py::ssize_t j = 0; j < n; ++j) {
+          out[j] = values[j];
+        }
+      });
+      ptrs[i] = out;
+    }
+    fn(ptrs, static_cast<int>(sizeof(double)));
+  }
+
+private:
+  [[nodiscard]] bool can_pass_typed(bool require_packed) const {
+    const auto stride = this->infos[0].strides.at(0);
+    if (!ValueGetter::has_implot_type(
+            this->types[0], ValueGetter::is_byte_swapped(this->infos[0])) ||
+        !ValueGetter::is_implot_stride(stride) ||
+        (require_packed && stride != this->infos[0].itemsize)) {
+      return false;
+    }
+    for (size_t i = 1; i < N; ++i) {
+      if (this->types[i] != this->types[0] ||
+          ValueGetter::is_byte_swapped(this->infos[i]) ||
+          this->infos[i].strides.at(0) != stride) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::array<py::buffer_info, N> infos;
+  std::array<ValueType, N> types;
+};
+
+#endif
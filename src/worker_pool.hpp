@@ -0,0 +1,145 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+#ifndef _WORKER_POOL_HPP
+#define _WORKER_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of threads splitting one job at a time into chunks. The calling
+// thread works on the job as well and only returns once all chunks are done,
+// so the chunks may reference the caller's stack. Jobs must not throw.
+class WorkerPool {
+public:
+  // threads counts the calling thread, a pool of one runs jobs inline.
+  explicit WorkerPool(int threads) {
+    for (int i = 1; i < threads; ++i) {
+      this->workers.emplace_back([this]() { work(); });
+    }
+  }
+  ~WorkerPool() {
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->stopping = true;
+    }
+    this->wake.notify_all();
+    for (auto& worker : this->workers) {
+      worker.join();
+    }
+  }
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  [[nodiscard]] int size() const {
+    return static_cast<int>(this->workers.size()) + 1;
+  }
+
+  // Calls fn(chunk) for every chunk in [0, chunks) and waits for all of them.
+  template <typename Fn> void run(int chunks, Fn&& fn) {
+    if (this->workers.empty() || chunks <= 1) {
+      for (int chunk = 0; chunk < chunks; ++chunk) {
+        fn(chunk);
+      }
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(this->mutex);
+      this->job = [&fn](int chunk) { fn(chunk); };
+      this->chunks = chunks;
+      this->next = 0;
+      this->busy = static_cast<int>(this->workers.size());
+      ++this->generation;
+    }
+    this->wake.notify_all();
+    run_chunks();
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this]() { return this->busy == 0; });
+    this->job = nullptr;
+  }
+
+private:
+  void run_chunks() {
+    for (int chunk = this->next++; chunk < this->chunks;
+         chunk = this->next++) {
+      this->job(chunk);
+    }
+  }
+
+  void work() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true) {
+      this->wake.wait(lock, [&]() {
+        return this->stopping || this->generation != seen;
+      });
+      if (this->stopping) {
+        return;
+      }
+      seen = this->generation;
+      lock.unlock();
+      run_chunks();
+      lock.lock();
+      if (--this->busy == 0) {
+        this->done.notify_one();
+      }
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  // The current job, only changed while no worker is busy
+  std::function<void(int)> job;
+  int chunks = 0;
+  std::atomic<int> next{0};
+  int busy = 0;
+  uint64_t generation = 0;
+  bool stopping = false;
+};
+
+#endif
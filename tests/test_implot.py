@@ -0,0 +1,680 @@
+from array import array
+import os
+import sys
+import threading
+
+import pytest
+import mahi_gui
+from mahi_gui import imgui, implot
+
+
+def render(draw, frames=3):
+    """Calls draw() inside a window for a few frames of a hidden window."""
+    if sys.platform.startswith("linux") and not (
+            os.environ.get("DISPLAY") or os.environ.get("WAYLAND_DISPLAY")):
+        pytest.skip("no display to open a window on")
+    errors = []
+
+    class App(mahi_gui.Application):
+        def __init__(self):
+            config = mahi_gui.Application.Config()
+            config.title = "test"
+            config.width = 640
+            config.height = 480
+            config.visible = False
+            super().__init__(config)
+            imgui.get_io().ini_filename = None
+            imgui.disable_viewports()
+            self.frame = 0
+
+        def _update(self):
+            try:
+                imgui.begin("test")
+                draw()
+                imgui.end()
+            except Exception as e:
+                errors.append(e)
+            self.frame += 1
+            if errors or self.frame == frames:
+                self.quit()
+
+    App().run()
+    if errors:
+        raise errors[0]
+
+
+def draw_plot(title, plot, limits=None, fit=False, **flags):
+    """Calls plot() between begin_plot() and end_plot(). limits (x_min, x_max,
+    y_min, y_max) are locked if given, with fit the axes are fit to the data.
+    Returns the plot limits."""
+    if limits is not None:
+        implot.set_next_plot_limits(*limits, cond=imgui.Condition.Always)
+    if fit:
+        implot.fit_next_plot_axes()
+    if implot.begin_plot(title, size=imgui.Vec2(600, 400), **flags):
+        plot()
+        limits = implot.get_plot_limits()
+        implot.end_plot()
+        return limits
+
+
+def render_vertices(draw, frames):
+    """Calls draw(frame) inside a window for frames frames. Returns the number
+    of vertices rendered in each frame but the last."""
+    vertices = []
+
+    def step():
+        # The metrics are those of the frame rendered before
+        vertices.append(imgui.get_io().metrics_render_vertices)
+        draw(len(vertices) - 1)
+
+    render(step, frames)
+    return vertices[1:]
+
+
+def render_plot(plot, frames=3, **kwargs):
+    """Renders a single plot, see draw_plot(). Returns the limits of the last
+    frame."""
+    limits = []
+    render(lambda: limits.append(draw_plot("##Plot", plot, **kwargs)), frames)
+    return limits[-1]
+
+
+def test_series():
+    s = implot.Series(array('d', [1.0, 2.0, 3.0]))
+    assert len(s) == 3
+    assert s.version == 0
+    s.touch()
+    assert s.version == 1
+    s.set_data(array('i', [0, 1]), array('f', [4.0, 5.0]))
+    assert len(s) == 2
+    assert s.version == 2
+    with pytest.raises(RuntimeError):
+        implot.Series(array('i', [0, 1]), array('f', [4.0]))
+
+
+def test_ring_series():
+    r = implot.RingSeries(4, channels=2)
+    assert len(r) == 0
+    r.push(0.0, array('d', [1.0, 2.0]))
+    assert len(r) == 1
+    r.extend(array('d', range(1, 7)), memoryview(array('d', range(12))).cast('B').cast('d', [6, 2]))
+    assert len(r) == 4
+    assert r.last_x == 6.0
+    with pytest.raises(ValueError):
+        r.push(7.0, 1.0)
+
+
+def test_plot_lines_2d_validation():
+    values = memoryview(array('d', range(6))).cast('B').cast('d', [2, 3])
+    with pytest.raises(ValueError):
+        implot.plot_lines_2d(["a"], values)
+    with pytest.raises(ValueError):
+        implot.plot_lines_interleaved(["a", "b"], values)
+    with pytest.raises(RuntimeError):
+        implot.plot_lines_2d(["a"], array('d', range(3)))
+
+
+def test_multi_buffer_validation():
+    xs = array('d', [0.0, 1.0, 2.0])
+    with pytest.raises(RuntimeError):
+        implot.plot_error_bars("e", xs, xs, array('f', [0.1, 0.2]))
+    with pytest.raises(RuntimeError):
+        implot.plot_shaded("s", xs, xs, array('i', [0, 1]))
+    with pytest.raises(ValueError):
+        implot.plot_pie_chart(["a", "b"], xs, 0.5, 0.5, 0.4)
+
+
+def test_heatmap_validation():
+    with pytest.raises(ValueError):
+        implot.HeatmapTexture(0, 4, 0.0, 1.0)
+    with pytest.raises(ValueError):
+        implot.HeatmapTexture(4, 4, 1.0, 1.0)
+    heatmap = implot.HeatmapTexture(2, 3, 0.0, 1.0)
+    assert (heatmap.rows, heatmap.cols) == (2, 3)
+    with pytest.raises(RuntimeError):
+        heatmap.update(memoryview(array('d', range(6))).cast('B').cast('d', [3, 2]))
+    with pytest.raises(RuntimeError):
+        implot.plot_heatmap("h", array('d', range(6)), 0.0, 1.0)
+
+
+def test_heatmap_texture_lifetime():
+    rows = memoryview(array('d', range(6))).cast('B').cast('d', [2, 3])
+    heatmaps = [implot.HeatmapTexture(2, 3, 0.0, 5.0) for _ in range(3)]
+
+    def plot():
+        # Each frame drops the heatmap plotted in the previous one
+        heatmaps[0].update(rows)
+        implot.plot_heatmap("h", heatmaps[0])
+        if len(heatmaps) > 1:
+            heatmaps.pop(0)
+
+    render_plot(plot, frames=4)
+    # Collected after the window is gone
+    heatmaps.clear()
+
+
+def test_sparkline_validation():
+    rows = memoryview(array('d', range(6))).cast('B').cast('d', [3, 2])
+    with pytest.raises(IndexError):
+        implot.sparkline(rows, row=3)
+    with pytest.raises(ValueError):
+        implot.sparkline_grid(rows, columns=0)
+    with pytest.raises(RuntimeError):
+        implot.sparkline_grid(
+            memoryview(array('d', range(8))).cast('B').cast('d', [2, 2, 2]))
+
+
+def test_sparkline_plot():
+    # Longer than the cells are wide, reduced per pixel column
+    values = array('d', [float(i % 37) for i in range(30000)])
+    values[5] = float("nan")
+    rows = memoryview(values).cast('B').cast('d', [3, 10000])
+
+    def draw(lines):
+        if imgui.begin_table("table", 2):
+            for row in range(3):
+                imgui.table_next_row()
+                imgui.table_next_cell()
+                imgui.text("row %d" % row)
+                imgui.table_next_cell()
+                if lines:
+                    implot.sparkline(rows, row=row, scale_min=0.0,
+                                     scale_max=20.0)
+            imgui.end_table()
+        if lines:
+            implot.sparkline(values, size=imgui.Vec2(300, 40))
+            implot.sparkline_grid(rows, columns=2)
+
+    with_lines = render_vertices(lambda frame: draw(True), frames=3)
+    without = render_vertices(lambda frame: draw(False), frames=3)
+    assert all(a > b for a, b in zip(with_lines, without))
+
+
+DTYPES = ["float16", "float32", "float64", ">f8", "int8", "uint8", "int16",
+          "uint16", "int32", "uint32", "int64", "uint64"]
+
+
+def test_plot_dtypes():
+    np = pytest.importorskip("numpy")
+    # On log axes ImPlot reads every value itself when fitting, through the
+    # typed API for same-typed xs and ys (including int64 as ImS64)
+    log = implot.AxisFlags.LogScale
+    xs = {dtype: np.arange(1, 101).astype(dtype) for dtype in DTYPES}
+    limits = {}
+
+    def draw():
+        for dtype in DTYPES:
+            limits[dtype] = draw_plot(
+                dtype, lambda: (implot.plot_line("xy", xs[dtype],
+                                                 xs[dtype][::-1].copy()),
+                                implot.plot_line("y", xs[dtype])),
+                fit=True, x_flags=log, y_flags=log)
+
+    render(draw)
+    for dtype in DTYPES:
+        x, y = limits[dtype].x, limits[dtype].y
+        assert (x.min, x.max) == pytest.approx((1.0, 100.0)), dtype
+        assert (y.min, y.max) == pytest.approx((1.0, 100.0)), dtype
+
+
+def test_buffer_formats():
+    np = pytest.importorskip("numpy")
+    for dtype in ("float16", ">f8", "<i4", "bool"):
+        assert len(implot.Series(np.zeros(3, dtype=dtype))) == 3
+    with pytest.raises(RuntimeError):
+        implot.Series(np.zeros(3, dtype="complex64"))
+
+
+def test_datetime_series():
+    np = pytest.importorskip("numpy")
+    ts = np.arange("2020-01-01", "2020-01-02", dtype="datetime64[h]")
+    s = implot.Series(ts.astype("datetime64[ns]"), np.zeros(len(ts)))
+    assert len(s) == 24
+    with pytest.raises(RuntimeError):
+        implot.Series(ts.astype("datetime64[M]"), np.zeros(len(ts)))
+    # Non-native byte order is read swapped, not as garbage
+    native = implot.Series(ts.astype("<M8[ns]"), np.zeros(len(ts)))
+    swapped = implot.Series(ts.astype(">M8[ns]"), np.zeros(len(ts)))
+    x = render_plot(lambda: implot.plot_line("t", native), fit=True).x
+    y = render_plot(lambda: implot.plot_line("t", swapped), fit=True).x
+    assert (y.min, y.max) == pytest.approx((x.min, x.max))
+
+
+def test_datetime_unit_multiple():
+    np = pytest.importorskip("numpy")
+    # 7 ms units, 1000 and 2000 of them are 7 and 14 seconds
+    s = implot.Series(np.array([1000, 2000], dtype="datetime64[7ms]"),
+                      np.zeros(2))
+    x = render_plot(lambda: implot.plot_line("t", s), fit=True).x
+    assert abs((x.min + x.max) / 2 - 10.5) < 1e-9
+
+
+def test_series_x_sorted():
+    ys = array('d', [0.0, 1.0, 2.0])
+    s = implot.Series(array('d', [0.0, 2.0, 1.0]), ys)
+    assert not s.x_sorted
+    s.set_data(array('d', [0.0, 1.0, 2.0]), ys)
+    assert s.x_sorted
+    # A declaration holds until new data is set
+    s.x_sorted = False
+    s.touch()
+    assert not s.x_sorted
+    s.set_data(array('d', [0.0, 1.0, 2.0]), ys)
+    assert s.x_sorted
+    s.set_data(array('d', [2.0, 1.0, 0.0]), ys)
+    assert not s.x_sorted
+
+
+def test_fit_skips_hidden_items():
+    xs = array('d', [0.0, 1.0, 2.0])
+    hidden = implot.Series(array('d', [0.0, 1000.0]), array('d', [0.0, 1000.0]))
+    ring = implot.RingSeries(2)
+    ring.extend(array('d', [-1000.0, 0.0]), array('d', [-1000.0, 0.0]))
+
+    def plot():
+        implot.plot_line("shown", xs, xs)
+        implot.hide_next_item(True, cond=imgui.Condition.Always)
+        implot.plot_line("series", hidden)
+        implot.hide_next_item(True, cond=imgui.Condition.Always)
+        implot.plot_line("ring", ring)
+
+    limits = render_plot(plot, fit=True)
+    assert -1.0 < limits.x.min and limits.x.max < 3.0
+    assert -1.0 < limits.y.min and limits.y.max < 3.0
+
+
+def test_ring_series_fit():
+    r = implot.RingSeries(4)
+    for i in range(10):
+        r.push(float(i), 100.0 if i == 0 else float(i))
+
+    def plot():
+        implot.plot_line("ring", r)
+
+    limits = render_plot(plot, fit=True)
+    # The oldest samples, holding the x minimum and y maximum, are gone
+    assert 5.0 < limits.x.min < 6.0 and 9.0 < limits.x.max < 10.0
+    assert 5.0 < limits.y.min < 6.0 and 9.0 < limits.y.max < 10.0
+    r.push(0.0, 0.0)
+    limits = render_plot(plot, fit=True)
+    assert -1.0 < limits.x.min < 0.0 and 9.0 < limits.x.max < 10.0
+
+
+def test_ring_series_overwrite():
+    r = implot.RingSeries(2)
+    for i in range(5):
+        r.push(float(i), float(-i))
+    assert len(r) == 2
+    assert r.last_x == 4.0
+    r.clear()
+    assert len(r) == 0
+
+
+def test_series_cache_meshes():
+    s = implot.Series(array('d', [1.0, 2.0]))
+    assert not s.cache_meshes
+    s.cache_meshes = True
+    assert s.cache_meshes
+    s.cache_meshes = False
+    assert not s.cache_meshes
+
+
+def test_series_cache_meshes_plot():
+    n = 1000
+    ys = array('d', [float(i % 7) for i in range(n)])
+
+    def run(cache):
+        s = implot.Series(array('d', range(n)), ys)
+        s.cache_meshes = cache
+
+        def draw(frame):
+            # Frames 0 and 2 (touched) and 4 (new limits) miss, the others hit
+            if frame == 2:
+                s.touch()
+            x_min, x_max = (0.0, n) if frame < 4 else (100.0, 200.0)
+            draw_plot("##Plot", lambda: (
+                implot.plot_line("line", s),
+                implot.plot_line("m4", s, decimation=implot.Decimation.M4),
+                implot.plot_scatter("scatter", s),
+                implot.plot_stairs("stairs", s)),
+                limits=(x_min, x_max, 0.0, 7.0))
+
+        return render_vertices(draw, frames=7)
+
+    cached = run(True)
+    assert all(count > 0 for count in cached)
+    # Replays add the same geometry as plotting
+    assert cached == run(False)
+
+
+def test_channel():
+    c = implot.Channel(4)
+    assert c.push(0.0, 1.0)
+    assert c.extend(array('d', [1.0, 2.0, 3.0, 4.0]), array('f', [0] * 4)) == 3
+    assert len(c) == 4
+    assert c.dropped == 1
+    assert not c.push(5.0, 0.0)
+    r = implot.RingSeries(8)
+    assert c.drain_into(r) == 4
+    assert len(c) == 0
+    assert len(r) == 4
+    assert r.last_x == 3.0
+    with pytest.raises(ValueError):
+        c.drain_into(implot.RingSeries(8, 2))
+
+
+def test_channel_threads():
+    batches, batch = 2000, 50
+    c = implot.Channel(256)
+    # Keeps only the newest sample of each drain
+    r = implot.RingSeries(1)
+    accepted = []
+
+    def produce():
+        for b in range(batches):
+            xs = array('d', range(b * batch, (b + 1) * batch))
+            # Queues the first samples of the batch, drops the rest
+            accepted.extend(xs[:c.extend(xs, xs)])
+
+    producer = threading.Thread(target=produce)
+    producer.start()
+    drained = 0
+    newest = []
+    while producer.is_alive() or len(c) > 0:
+        count = c.drain_into(r)
+        if count > 0:
+            drained += count
+            newest.append(r.last_x)
+    producer.join()
+    assert drained + c.dropped == batches * batch
+    assert drained == len(accepted)
+    # Drained in the order queued
+    assert all(a < b for a, b in zip(newest, newest[1:]))
+    assert set(newest) <= set(accepted)
+    assert r.last_x == accepted[-1]
+
+
+def test_decimation():
+    n = 100000
+    xs = array('d', range(1, n + 1))
+    ys = array('d', [1.0 + i % 10 for i in range(n)])
+    ys[n // 2] = 1000.0
+    log = implot.AxisFlags.LogScale
+    for mode in (implot.Decimation.M4, implot.Decimation.LTTB):
+        def plot():
+            implot.plot_line("d", xs, ys, decimation=mode)
+            implot.plot_stairs("s", implot.Series(xs, ys), decimation=mode)
+
+        # On log axes ImPlot fits to the decimated points, which span the
+        # whole series and keep the spike
+        limits = render_plot(plot, fit=True, x_flags=log, y_flags=log)
+        assert (limits.x.min, limits.x.max) == pytest.approx((1.0, n))
+        assert (limits.y.min, limits.y.max) == pytest.approx((1.0, 1000.0))
+        # Zoomed in, only the visible columns are decimated
+        render_plot(plot, limits=(1000.0, 2000.0, 0.0, 20.0))
+
+
+def test_render_threads():
+    assert implot.get_render_threads() == 1
+    implot.set_render_threads(4, min_count=1000)
+    assert implot.get_render_threads() == 4
+    implot.set_render_threads(1)
+    assert implot.get_render_threads() == 1
+    with pytest.raises(ValueError):
+        implot.set_render_threads(-1)
+
+
+def test_render_threads_plot():
+    n = 200000
+    ys = array('d', [float(i % 100) for i in range(n)])
+    xs = array('d', range(n))
+    series = implot.Series(xs, ys)
+    implot.set_render_threads(4, min_count=1000)
+    try:
+        # Locked limits, ImPlot tessellates by itself while fitting
+        render_plot(lambda: (implot.plot_line("values", ys),
+                             implot.plot_line("xy", xs, ys),
+                             implot.plot_line("series", series)),
+                    limits=(0.0, n, 0.0, 100.0))
+    finally:
+        implot.set_render_threads(1)
+
+
+def test_linked_limits():
+    with pytest.raises(KeyError):
+        implot.get_linked_limits("test_time")
+    # Getters do not create groups
+    with pytest.raises(KeyError):
+        implot.get_linked_limits("test_time")
+    implot.set_linked_limits("test_time", -2.0, 5.0)
+    assert implot.get_linked_limits("test_time") == (-2.0, 5.0)
+
+
+def test_linked_limits_plot():
+    ys = array('d', [0.0, 1.0, 0.5])
+    limits = {}
+
+    def draw():
+        # The locked plot pushes its limits to the group, the other one
+        # pulls them
+        implot.link_next_plot_limits(x="test_link")
+        limits["locked"] = draw_plot("locked", lambda: implot.plot_line("a", ys),
+                                     limits=(-2.0, 5.0, 0.0, 1.0))
+        implot.link_next_plot_limits(x="test_link")
+        limits["linked"] = draw_plot("linked", lambda: implot.plot_line("b", ys))
+
+    render(draw)
+    for name in ("locked", "linked"):
+        x = limits[name].x
+        assert (x.min, x.max) == (-2.0, 5.0), name
+    assert implot.get_linked_limits("test_link") == (-2.0, 5.0)
+
+
+def test_fast_markers():
+    assert not implot.get_fast_markers()
+    implot.set_fast_markers(True)
+    assert implot.get_fast_markers()
+    implot.set_fast_markers(False)
+    assert not implot.get_fast_markers()
+
+
+def test_fast_markers_plot():
+    n = 100000
+    xs = array('d', [float(i % 1000) for i in range(n)])
+    ys = array('d', [float(i * 7 % 1000) for i in range(n)])
+    series = implot.Series(xs, ys)
+    series.cache_meshes = True
+    # Markers below 1.5 pixels become single quads
+    small = implot.ItemStyle(marker=int(implot.Marker.Square), marker_size=1.0)
+    # About 64000 vertices, markers after it are left to ImPlot
+    line = array('d', [float(i % 2) for i in range(16000)])
+
+    def plot():
+        implot.plot_scatter("dense", xs, ys)
+        implot.plot_scatter("small", xs, ys, style=small)
+        implot.plot_scatter("series", series)
+
+    implot.set_fast_markers(True)
+    try:
+        # Fit frames are plotted by ImPlot, which sees every point
+        limits = render_plot(plot, fit=True)
+        assert (limits.x.min, limits.x.max) == (0.0, 999.0)
+        assert (limits.y.min, limits.y.max) == (0.0, 999.0)
+        render_plot(plot, limits=(0.0, 1000.0, 0.0, 1000.0))
+        render_plot(lambda: (implot.plot_line("line", line), plot()),
+                    limits=(0.0, 16000.0, 0.0, 1000.0))
+    finally:
+        implot.set_fast_markers(False)
+
+
+def test_series_pyramid():
+    ys = array('d', [float(i % 100) for i in range(10000)])
+    p = implot.SeriesPyramid(ys, x0=1.0, dx=0.5)
+    assert len(p) == 10000
+    assert p.levels == 4
+    assert p.summary(0, 10000) == (0.0, 99.0, 49.5)
+    assert p.summary(150, 160) == (50.0, 59.0, 54.5)
+    with pytest.raises(IndexError):
+        p.summary(0, 10001)
+    with pytest.raises(ValueError):
+        implot.SeriesPyramid(array('d', [1.0, 0.0]), ys[:2])
+
+
+def test_strided_buffers():
+    values = array('d', [float(i % 300) for i in range(2000)])
+    odd = memoryview(values)[1::2]
+    p = implot.SeriesPyramid(odd)
+    assert len(p) == 1000
+    for first, last in ((0, 1000), (70, 650), (3, 5)):
+        expected = odd[first:last].tolist()
+        assert p.summary(first, last) == pytest.approx(
+            (min(expected), max(expected), sum(expected) / len(expected)))
+
+    # Series read the strides of both buffers
+    ys = array('d', [-float(i) for i in range(20)])
+    s = implot.Series(memoryview(ys)[::4], memoryview(ys)[1::4])
+    limits = render_plot(lambda: implot.plot_line("s", s), fit=True)
+    assert (limits.x.min, limits.x.max) == (-16.0, 0.0)
+    assert (limits.y.min, limits.y.max) == (-17.0, -1.0)
+
+
+def test_strided_columns():
+    np = pytest.importorskip("numpy")
+    values = np.arange(30.0).reshape(10, 3)
+    p = implot.SeriesPyramid(values[:, 0], values[:, 2])
+    assert p.summary(0, 10) == (2.0, 29.0, 15.5)
+    # Same stride for xs and ys, handed to ImPlot's typed API
+    log = implot.AxisFlags.LogScale
+    limits = render_plot(
+        lambda: implot.plot_line("c", values[1:, 0], values[1:, 1]),
+        fit=True, x_flags=log, y_flags=log)
+    assert (limits.x.min, limits.x.max) == pytest.approx((3.0, 27.0))
+    assert (limits.y.min, limits.y.max) == pytest.approx((4.0, 28.0))
+
+
+def test_mapped_file(tmp_path):
+    path = tmp_path / "samples.bin"
+    path.write_bytes(b"head" + array('h', range(10)).tobytes() + b"x")
+    f = implot.MappedFile(str(path), 'h', channels=2, offset=4)
+    assert len(f) == 5
+    assert memoryview(f).shape == (5, 2)
+    assert memoryview(f.channel(1)).tolist() == [1, 3, 5, 7, 9]
+    f.prefetch(1, 3)
+    f.advise(implot.Access.Random)
+    planar = implot.MappedFile(str(path), 'h', channels=2, offset=4,
+                               interleaved=False)
+    assert memoryview(planar.channel(1)).tolist() == [5, 6, 7, 8, 9]
+    with pytest.raises(IndexError):
+        f.channel(2)
+
+
+def test_load_csv(tmp_path):
+    path = tmp_path / "log.csv"
+    path.write_text("t,\"v\"\n0,1.5\n\n1,x\n2,3e2\n")
+    columns = implot.load_csv(str(path), threads=2)
+    assert list(columns) == ["t", "v"]
+    assert memoryview(columns["t"]).tolist() == [0.0, 1.0, 2.0]
+    v = memoryview(columns["v"]).tolist()
+    assert v[0] == 1.5 and v[1] != v[1] and v[2] == 300.0
+    xs, ys = implot.load_columns(
+        memoryview(array('h', [1, 2, 3, 4])).cast('B').cast('h', [2, 2]))
+    assert memoryview(ys).tolist() == [2.0, 4.0]
+
+
+def test_load_csv_chunks(tmp_path):
+    # About 5 MiB, split into chunks of roughly 1 MiB at line boundaries. The
+    # last line has no line break.
+    rows = 300000
+    lines = ["t,v"]
+    for i in range(rows):
+        lines.append("%d,%d.5" % (i, i))
+        if i % 997 == 0:
+            lines.append("")
+    path = tmp_path / "large.csv"
+    path.write_bytes("\r\n".join(lines).encode())
+    for threads in (1, 2, 4):
+        columns = implot.load_csv(str(path), threads=threads)
+        v = memoryview(columns["v"])
+        assert len(v) == rows
+        assert v[rows - 1] == rows - 0.5
+        # Every row once, in order
+        assert memoryview(columns["t"]).tolist() == list(range(rows))
+
+
+def test_shared_ring():
+    name = "mahi_gui_test_%d" % os.getpid()
+    writer = implot.SharedRing.create(name, 16, channels=2)
+    reader = implot.SharedRing.attach(name)
+    assert reader.capacity == 16 and reader.channels == 2
+    ys = memoryview(array('d', range(40))).cast('B').cast('d', [20, 2])
+    writer.extend(array('d', range(20)), ys)
+    writer.push(20.0, array('d', [1.0, 2.0]))
+    assert reader.cursor == 21
+    assert reader.last_x == 20.0
+    assert len(reader) == 14
+    with pytest.raises(RuntimeError):
+        reader.push(0.0, array('d', [1.0, 2.0]))
+
+
+def test_digital_series():
+    xs = array('d', [0.0, 1.0, 2.0, 3.0])
+    d = implot.DigitalSeries(xs, array('B', [0, 1, 3, 1]))
+    assert len(d) == 4
+    assert d.channels == 8
+    d.touch()
+    assert implot.DigitalSeries(xs, array('Q', [0] * 4)).channels == 64
+    with pytest.raises(ValueError):
+        implot.DigitalSeries(xs, array('B', [0] * 4), bitorder="middle")
+    with pytest.raises(RuntimeError):
+        implot.DigitalSeries(xs, array('d', [0.0] * 4))
+    with pytest.raises(RuntimeError):
+        implot.DigitalSeries(xs, array('B', [0] * 3))
+    with pytest.raises(ValueError):
+        implot.plot_digital_packed(["a"] * 9, d)
+    with pytest.raises(ValueError):
+        implot.DigitalSeries(array('d', [0.0, 2.0, 1.0]), array('B', [0] * 3))
+    xs[0] = 5.0
+    with pytest.raises(ValueError):
+        d.touch()
+
+
+def test_item_style():
+    circle = int(implot.Marker.Circle)
+    style = implot.ItemStyle(line_weight=2.0, marker=circle)
+    assert style.line_weight == 2.0
+    assert style.marker == circle
+    assert style.fill_alpha == -1.0
+    assert style.line_color.w == -1.0
+    style.line_color = imgui.Vec4(1.0, 0.0, 0.0, 1.0)
+    assert style.line_color.x == 1.0
+
+
+def test_item_style_plot():
+    red = imgui.Vec4(1.0, 0.0, 0.0, 1.0)
+    style = implot.ItemStyle(line_color=red, line_weight=3.0, fill_color=red,
+                             marker=int(implot.Marker.Circle),
+                             marker_outline=red, marker_fill=red)
+    xs = array('d', [0.0, 1.0, 2.0])
+    ys = array('d', [1.0, 2.0, 0.5])
+    items = {
+        "line": lambda label, **kw: implot.plot_line(label, xs, ys, **kw),
+        "scatter": lambda label, **kw: implot.plot_scatter(label, xs, ys, **kw),
+        "shaded": lambda label, **kw: implot.plot_shaded(label, xs, ys, **kw),
+    }
+    colors = {}
+
+    def plot():
+        for name, item in items.items():
+            item(name, style=style)
+            colors[name] = implot.get_last_item_color()
+            # The style only applies to the item it was passed to
+            item(name + " default")
+            colors[name + " default"] = implot.get_last_item_color()
+
+    render_plot(plot)
+    for name in items:
+        color = colors[name]
+        assert (color.x, color.y, color.z) == (1.0, 0.0, 0.0), name
+        color = colors[name + " default"]
+        assert (color.x, color.y, color.z) != (1.0, 0.0, 0.0), name
@@ -0,0 +1,298 @@
+/******************************************************************************
+
+Copyright 2020 Joel Linn
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+   list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright notice,
+   this list of conditions and the following disclaimer in the documentation
+   and/or other materials provided with the distribution.
+
+3. Neither the name of the copyright holder nor the names of its contributors
+   may be used to endorse or promote products derived from this software
+   without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+You are under no obligation whatsoever to provide any bug fixes, patches, or
+upgrades to the features, functionality or performance of the source code
+("Enhancements") to anyone; however, if you choose to make your Enhancements
+available either publicly, or directly to the author of this software, without
+imposing a separate written license agreement for such Enhancements, then you
+hereby grant the following license: a non-exclusive, royalty-free perpetual
+license to install, use, modify, prepare derivative works, incorporate into
+other computer software, distribute, and sublicense such enhancements or
+derivative works thereof, in binary and source code form.
+
+******************************************************************************/
+
+// Tests of the data reduction and tessellation kernels on known inputs. Exits
+// with a non-zero status if any check fails.
+
+#include <cstdio>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "plot_kernels.hpp"
+#include "plot_parallel.hpp"
+
+static int failures = 0;
+
+#define CHECK(expr)                                                            \
+  do {                                                                         \
+    if (!(expr)) {                                                             \
+      std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr);    \
+      ++failures;                                                              \
+    }                                                                          \
+  } while (false)
+
+using Points = std::vector<std::pair<double, double>>;
+
+static Points to_points(const std::vector<double>& out) {
+  Points points;
+  for (std::size_t i = 0; i + 1 < out.size(); i += 2) {
+    points.emplace_back(out[i], out[i + 1]);
+  }
+  return points;
+}
+
+static bool contains(const Points& points, double x, double y) {
+  for (const auto& point : points) {
+    if (point.first == x && point.second == y) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Two columns, each with its minimum and maximum somewhere inside.
+static void test_m4_columns() {
+  std::vector<double> ys(100, 0.0);
+  ys[10] = 5.0;
+  ys[20] = -3.0;
+  ys[60] = -8.0;
+  ys[70] = 9.0;
+  std::vector<double> out;
+  kernels::decimate_m4(kernels::IndexArray{},
+                       kernels::PackedArray<double>{ys.data()}, 100,
+                       {0.0, 50.0, 99.0}, out);
+  const Points expected = {{0, 0},  {10, 5},  {20, -3}, {49, 0},
+                           {50, 0}, {60, -8}, {70, 9},  {99, 0}};
+  CHECK(to_points(out) == expected);
+}
+
+// Points outside the edges are dropped, but for one on each side.
+static void test_m4_outside_edges() {
+  std::vector<double> ys(100);
+  for (int i = 0; i < 100; ++i) {
+    ys[i] = i % 7;
+  }
+  std::vector<double> out;
+  kernels::decimate_m4(kernels::IndexArray{},
+                       kernels::PackedArray<double>{ys.data()}, 100,
+                       {20.5, 30.5, 40.5}, out);
+  const auto points = to_points(out);
+  CHECK(points.size() <= 2 + 2 * 4);
+  CHECK(points.front() == std::make_pair(20.0, ys[20]));
+  CHECK(points.back() == std::make_pair(41.0, ys[41]));
+  for (std::size_t i = 1; i < points.size(); ++i) {
+    CHECK(points[i - 1].first < points[i].first);
+  }
+}
+
+// Short columns are kept as they are.
+static void test_m4_short_columns() {
+  const std::vector<double> xs = {0.0, 1.0, 2.0, 10.0, 11.0};
+  const std::vector<double> ys = {1.0, 2.0, 3.0, 4.0, 5.0};
+  std::vector<double> out;
+  kernels::decimate_m4(kernels::PackedArray<double>{xs.data()},
+                       kernels::PackedArray<double>{ys.data()}, 5,
+                       {0.0, 5.0, 11.0}, out);
+  CHECK(to_points(out) == Points({{0, 1}, {1, 2}, {2, 3}, {10, 4}, {11, 5}}));
+}
+
+// The first and last point and a single spike survive.
+static void test_lttb() {
+  std::vector<double> ys(1000, 0.0);
+  ys[500] = 100.0;
+  std::vector<double> out;
+  kernels::decimate_lttb(kernels::IndexArray{},
+                         kernels::PackedArray<double>{ys.data()}, 0, 1000, 10,
+                         out);
+  const auto points = to_points(out);
+  CHECK(points.size() == 10);
+  CHECK(points.front() == std::make_pair(0.0, 0.0));
+  CHECK(points.back() == std::make_pair(999.0, 0.0));
+  CHECK(contains(points, 500.0, 100.0));
+  for (std::size_t i = 1; i < points.size(); ++i) {
+    CHECK(points[i - 1].first < points[i].first);
+  }
+
+  // At most threshold points are passed through
+  kernels::decimate_lttb(kernels::IndexArray{},
+                         kernels::PackedArray<double>{ys.data()}, 495, 505, 10,
+                         out);
+  CHECK(to_points(out).size() == 10);
+  CHECK(to_points(out).front().first == 495.0);
+}
+
+// LTTB of the columns keeps one point on each side of the edges.
+static void test_decimate_columns() {
+  std::vector<double> ys(1000);
+  for (int i = 0; i < 1000; ++i) {
+    ys[i] = i % 13;
+  }
+  const std::vector<double> edges = {100.5, 200.5, 300.5, 400.5};
+  std::vector<double> out;
+  kernels::decimate_columns(kernels::IndexArray{},
+                            kernels::PackedArray<double>{ys.data()}, 1000,
+                            kernels::Decimation::LTTB, edges, out);
+  auto points = to_points(out);
+  CHECK(points.size() == 6);
+  CHECK(points.front() == std::make_pair(100.0, ys[100]));
+  CHECK(points.back() == std::make_pair(401.0, ys[401]));
+
+  kernels::decimate_columns(kernels::IndexArray{},
+                            kernels::PackedArray<double>{ys.data()}, 1000,
+                            kernels::Decimation::M4, edges, out);
+  points = to_points(out);
+  CHECK(points.front() == std::make_pair(100.0, ys[100]));
+  CHECK(points.back() == std::make_pair(401.0, ys[401]));
+  CHECK(contains(points, 103.0, 12.0));
+
+  // Edges beyond the data keep everything in range
+  kernels::decimate_columns(kernels::IndexArray{},
+                            kernels::PackedArray<double>{ys.data()}, 1000,
+                            kernels::Decimation::LTTB, {-10.0, 2000.0}, out);
+  points = to_points(out);
+  CHECK(points.front() == std::make_pair(0.0, ys[0]));
+  CHECK(points.back() == std::make_pair(999.0, ys[999]));
+}
+
+static bool same_pos(const ImDrawVert& vertex, float x, float y) {
+  return vertex.pos.x == x && vertex.pos.y == y;
+}
+
+// The quads of segments match ImPlot's AddLine(): the line widened by half
+// the weight to each side.
+static void test_add_segment() {
+  const ImVec2 uv(0.5f, 0.5f);
+  std::vector<ImDrawVert> out;
+  detail::add_segment(out, ImVec2(0, 0), ImVec2(10, 0), 2.0f, 0xFF0000FF, uv);
+  detail::add_segment(out, ImVec2(0, 0), ImVec2(0, 5), 4.0f, 0xFF0000FF, uv);
+  // A single point becomes an empty quad
+  detail::add_segment(out, ImVec2(3, 3), ImVec2(3, 3), 2.0f, 0xFF0000FF, uv);
+  CHECK(out.size() == 12);
+  CHECK(same_pos(out[0], 0, -1) && same_pos(out[1], 10, -1));
+  CHECK(same_pos(out[2], 10, 1) && same_pos(out[3], 0, 1));
+  CHECK(same_pos(out[4], 2, 0) && same_pos(out[5], 2, 5));
+  CHECK(same_pos(out[6], -2, 5) && same_pos(out[7], -2, 0));
+  for (int i = 8; i < 12; ++i) {
+    CHECK(same_pos(out[i], 3, 3));
+  }
+  CHECK(out[0].col == 0xFF0000FF && out[0].uv.x == 0.5f);
+}
+
+// Whether the draw list holds vertices unchanged and two triangles (0, 1, 2)
+// and (0, 2, 3) per quad, resolving indices through each command's offsets.
+static bool holds_quads(const ImDrawList& draw_list,
+                        const std::vector<ImDrawVert>& vertices) {
+  if (draw_list.VtxBuffer.Size != static_cast<int>(vertices.size()) ||
+      draw_list.IdxBuffer.Size != static_cast<int>(vertices.size() / 4 * 6) ||
+      std::memcmp(draw_list.VtxBuffer.Data, vertices.data(),
+                  vertices.size() * sizeof(ImDrawVert)) != 0) {
+    return false;
+  }
+  static const unsigned int corners[6] = {0, 1, 2, 0, 2, 3};
+  unsigned int quad = 0;
+  for (const ImDrawCmd& cmd : draw_list.CmdBuffer) {
+    if (cmd.ElemCount % 6 != 0) {
+      return false;
+    }
+    for (unsigned int i = 0; i < cmd.ElemCount; ++i) {
+      const unsigned int vertex =
+          cmd.VtxOffset + draw_list.IdxBuffer[cmd.IdxOffset + i];
+      if (vertex != 4 * (quad + i / 6) + corners[i % 6]) {
+        return false;
+      }
+    }
+    quad += cmd.ElemCount / 6;
+  }
+  return quad == vertices.size() / 4;
+}
+
+// With 16 bit indices, quads are split into a new draw command once the
+// vertex index would pass 65535. Quads are never split.
+static void test_append_quads() {
+  ImDrawListSharedData shared_data;
+  ImDrawList draw_list(&shared_data);
+  draw_list._ResetForNewFrame();
+  draw_list.Flags |= ImDrawListFlags_AllowVtxOffset;
+  const bool small_indices = sizeof(ImDrawIdx) == 2;
+
+  // 64000 vertices, then 383 more quads fit below 65535
+  std::vector<ImDrawVert> vertices;
+  for (int i = 0; i < 17000; ++i) {
+    const auto x = static_cast<float>(i);
+    detail::add_segment(vertices, ImVec2(x, 0), ImVec2(x + 1, 1), 1.0f,
+                        0xFFFFFFFF, ImVec2(0, 0));
+  }
+  const std::vector<ImDrawVert> first(vertices.begin(),
+                                      vertices.begin() + 4 * 16000);
+  const std::vector<ImDrawVert> second(vertices.begin() + 4 * 16000,
+                                       vertices.end());
+  detail::append_quads(draw_list, first);
+  CHECK(draw_list.CmdBuffer.Size == 1);
+  CHECK(draw_list._VtxCurrentIdx == 64000);
+  detail::append_quads(draw_list, second);
+  CHECK(holds_quads(draw_list, vertices));
+  if (small_indices) {
+    CHECK(draw_list.CmdBuffer.Size == 2);
+    CHECK(draw_list.CmdBuffer[0].ElemCount == (16000 + 383) * 6);
+    CHECK(draw_list.CmdBuffer[1].VtxOffset == (16000 + 383) * 4);
+    CHECK(draw_list._VtxCurrentIdx == (1000 - 383) * 4);
+  } else {
+    CHECK(draw_list.CmdBuffer.Size == 1);
+    CHECK(draw_list._VtxCurrentIdx == 68000);
+  }
+
+  // More quads than one command holds at all
+  draw_list._ResetForNewFrame();
+  draw_list.Flags |= ImDrawListFlags_AllowVtxOffset;
+  detail::append_quads(draw_list, vertices);
+  CHECK(holds_quads(draw_list, vertices));
+  CHECK(draw_list.CmdBuffer.Size == (small_indices ? 2 : 1));
+  if (small_indices) {
+    CHECK(draw_list.CmdBuffer[0].ElemCount == 16383 * 6);
+  }
+}
+
+int main() {
+  test_m4_columns();
+  test_m4_outside_edges();
+  test_m4_short_columns();
+  test_lttb();
+  test_decimate_columns();
+  test_add_segment();
+  test_append_quads();
+  if (failures > 0) {
+    std::printf("%d checks failed\n", failures);
+    return 1;
+  }
+  std::printf("All checks passed\n");
+  return 0;
+}